@@ -30,6 +30,13 @@ using namespace Dorothy;
 #include "Zip/Support/ZipUtils.h"
 #include "Zip/Support/unzip.h"
 
+#if BX_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif // BX_PLATFORM_WINDOWS
+
 /// when define returns true it means that our architecture uses big endian
 #define CC_HOST_IS_BIG_ENDIAN (bool)(*(unsigned short *)"\0\xff" < 0x100) 
 #define CC_SWAP32(i)  ((i & 0x000000ff) << 24 | (i & 0x0000ff00) << 8 | (i & 0x00ff0000) >> 8 | (i & 0xff000000) >> 24)
@@ -42,27 +49,169 @@ using namespace Dorothy;
 // --------------------- ZipFile ---------------------
 // from unzip.cpp
 #define UNZ_MAXFILENAMEINZIP 256
+#define SIZEZIPLOCALHEADER 0x1e
+#define LOCALHEADERMAGIC 0x04034b50
 
 struct ZipEntryInfo
 {
-    unz_file_pos pos;
-    uLong uncompressed_size;
+	ZPOS64_T offset; // offset of the local header
+	ZPOS64_T compressed_size;
+	ZPOS64_T uncompressed_size;
+	int method;
 };
 
 class ZipFilePrivate
 {
 public:
     unzFile zipFile;
+	// entries are read with positional reads that share no file position
+#if BX_PLATFORM_WINDOWS
+	HANDLE file;
+#else
+	int file;
+#endif // BX_PLATFORM_WINDOWS
 
     // std::unordered_map is faster if available on the platform
     typedef std::unordered_map<std::string, struct ZipEntryInfo> FileListContainer;
     FileListContainer fileList;
 	std::unordered_set<std::string> folderList;
+
+	bool isOpen() const;
+	bool readAt(ZPOS64_T offset, void* buffer, size_t size) const;
+	bool readEntry(const ZipEntryInfo& entry, unsigned char* output, const std::function<void(unsigned char*,int)>& handler) const;
 };
 
+bool ZipFilePrivate::isOpen() const
+{
+#if BX_PLATFORM_WINDOWS
+	return zipFile && file != INVALID_HANDLE_VALUE;
+#else
+	return zipFile && file >= 0;
+#endif // BX_PLATFORM_WINDOWS
+}
+
+bool ZipFilePrivate::readAt(ZPOS64_T offset, void* buffer, size_t size) const
+{
+#if BX_PLATFORM_WINDOWS
+	OVERLAPPED overlapped = {0};
+	overlapped.Offset = (DWORD)(offset & 0xffffffff);
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	DWORD readSize = 0;
+	return ReadFile(file, buffer, (DWORD)size, &readSize, &overlapped) && readSize == size;
+#else
+	char* data = (char*)buffer;
+	while (size > 0)
+	{
+		ssize_t readSize = pread(file, data, size, (off_t)offset);
+		if (readSize <= 0)
+		{
+			if (readSize < 0 && errno == EINTR) continue;
+			return false;
+		}
+		data += readSize;
+		offset += readSize;
+		size -= readSize;
+	}
+	return true;
+#endif // BX_PLATFORM_WINDOWS
+}
+
+// write the whole entry to output when it is provided, otherwise pass it to the handler by chunks
+bool ZipFilePrivate::readEntry(const ZipEntryInfo& entry, unsigned char* output, const std::function<void(unsigned char*,int)>& handler) const
+{
+	// sizes of the local header name and extra field may differ from the central directory
+	unsigned char header[SIZEZIPLOCALHEADER];
+	if (!readAt(entry.offset, header, SIZEZIPLOCALHEADER))
+	{
+		return false;
+	}
+	uLong magic = header[0] | (header[1] << 8) | (header[2] << 16) | ((uLong)header[3] << 24);
+	if (magic != LOCALHEADERMAGIC)
+	{
+		return false;
+	}
+	uLong nameSize = header[26] | (header[27] << 8);
+	uLong extraSize = header[28] | (header[29] << 8);
+	ZPOS64_T offset = entry.offset + SIZEZIPLOCALHEADER + nameSize + extraSize;
+
+	Uint8 buffer[DORA_COPY_BUFFER_SIZE];
+	if (entry.method == 0)
+	{
+		if (output)
+		{
+			return readAt(offset, output, (size_t)entry.uncompressed_size);
+		}
+		for (ZPOS64_T pos = 0; pos < entry.compressed_size;)
+		{
+			int size = (int)std::min(entry.compressed_size - pos, (ZPOS64_T)DORA_COPY_BUFFER_SIZE);
+			if (!readAt(offset + pos, buffer, size))
+			{
+				return false;
+			}
+			handler(buffer, size);
+			pos += size;
+		}
+		return true;
+	}
+	if (entry.method != Z_DEFLATED)
+	{
+		return false;
+	}
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(z_stream));
+	// zip entries are raw deflate streams without zlib header
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+	{
+		return false;
+	}
+	Uint8 chunk[DORA_COPY_BUFFER_SIZE];
+	if (output)
+	{
+		stream.next_out = output;
+		stream.avail_out = (uInt)entry.uncompressed_size;
+	}
+	ZPOS64_T pos = 0;
+	int result = Z_OK;
+	while (result != Z_STREAM_END)
+	{
+		if (stream.avail_in == 0)
+		{
+			if (pos >= entry.compressed_size) break;
+			uInt size = (uInt)std::min(entry.compressed_size - pos, (ZPOS64_T)DORA_COPY_BUFFER_SIZE);
+			if (!readAt(offset + pos, buffer, size)) break;
+			stream.next_in = buffer;
+			stream.avail_in = size;
+			pos += size;
+		}
+		if (!output)
+		{
+			stream.next_out = chunk;
+			stream.avail_out = DORA_COPY_BUFFER_SIZE;
+		}
+		result = inflate(&stream, Z_NO_FLUSH);
+		if (result != Z_OK && result != Z_STREAM_END) break;
+		if (!output)
+		{
+			int size = DORA_COPY_BUFFER_SIZE - (int)stream.avail_out;
+			if (size > 0)
+			{
+				handler(chunk, size);
+			}
+		}
+	}
+	inflateEnd(&stream);
+	return result == Z_STREAM_END && stream.total_out == entry.uncompressed_size;
+}
+
 ZipFile::ZipFile(const std::string& zipFile, const std::string& filter)
     : m_data(new ZipFilePrivate)
 {
+#if BX_PLATFORM_WINDOWS
+	m_data->file = CreateFileA(zipFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+	m_data->file = open(zipFile.c_str(), O_RDONLY);
+#endif // BX_PLATFORM_WINDOWS
     m_data->zipFile = unzOpen(zipFile.c_str());
     if (m_data->zipFile)
     {
@@ -76,6 +225,17 @@ ZipFile::~ZipFile()
     {
         unzClose(m_data->zipFile);
     }
+#if BX_PLATFORM_WINDOWS
+	if (m_data && m_data->file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_data->file);
+	}
+#else
+	if (m_data && m_data->file >= 0)
+	{
+		close(m_data->file);
+	}
+#endif // BX_PLATFORM_WINDOWS
     delete m_data;
 	m_data = nullptr;
 }
@@ -104,30 +264,28 @@ bool ZipFile::setFilter(const std::string& filterStr)
                 szCurrentFileName, sizeof(szCurrentFileName) - 1);
         while (err == UNZ_OK)
         {
-            unz_file_pos posInfo;
-            int posErr = unzGetFilePos(m_data->zipFile, &posInfo);
-            if (posErr == UNZ_OK)
+            ZPOS64_T offset = unzGetCurrentFileLocalHeaderOffset64(m_data->zipFile);
+            std::string currentFileName(szCurrentFileName);
+
+			// cache info about filtered files only (like 'assets/')
+            if (filter.empty()
+                || currentFileName.substr(0, filter.length()) == filter)
             {
-                std::string currentFileName(szCurrentFileName);
-
-				// cache info about filtered files only (like 'assets/')
-                if (filter.empty()
-                    || currentFileName.substr(0, filter.length()) == filter)
-                {
-                    ZipEntryInfo entry;
-                    entry.pos = posInfo;
-                    entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
-
-                    m_data->fileList[currentFileName] = entry;
-					size_t pos = currentFileName.rfind('/');
-					while (pos != std::string::npos)
-					{
-						currentFileName = currentFileName.substr(0, pos);
-						m_data->folderList.insert(currentFileName);
-						pos = currentFileName.rfind('/');
-					}
+                ZipEntryInfo entry;
+                entry.offset = offset;
+                entry.compressed_size = fileInfo.compressed_size;
+                entry.uncompressed_size = fileInfo.uncompressed_size;
+                entry.method = (int)fileInfo.compression_method;
+
+                m_data->fileList[currentFileName] = entry;
+				size_t pos = currentFileName.rfind('/');
+				while (pos != std::string::npos)
+				{
+					currentFileName = currentFileName.substr(0, pos);
+					m_data->folderList.insert(currentFileName);
+					pos = currentFileName.rfind('/');
 				}
-            }
+			}
             // next file - also get the information about it
             err = unzGoToNextFile64(m_data->zipFile, &fileInfo,
                     szCurrentFileName, sizeof(szCurrentFileName) - 1);
@@ -211,82 +369,56 @@ bool ZipFile::isFolder(const std::string& pathStr) const
 	return m_data->folderList.find(path) != m_data->folderList.end();
 }
 
-unsigned char* ZipFile::getFileData(const std::string& fileName, unsigned long* pSize)
+unsigned char* ZipFile::getFileData(const std::string& fileName, unsigned long* pSize) const
 {
-    unsigned char* pBuffer = NULL;
-    if (pSize)
-    {
-        *pSize = 0;
-    }
-
-    BLOCK_START
-    {
-        BREAK_IF(!m_data->zipFile);
-        BREAK_IF(fileName.empty());
-		
-		std::string file(fileName);
-
-        ZipFilePrivate::FileListContainer::const_iterator it = m_data->fileList.find(file);
-        BREAK_IF(it == m_data->fileList.end());
-
-        ZipEntryInfo fileInfo = it->second;
+	unsigned char* pBuffer = NULL;
+	if (pSize)
+	{
+		*pSize = 0;
+	}
 
-        int nRet = unzGoToFilePos(m_data->zipFile, &fileInfo.pos);
-        BREAK_IF(UNZ_OK != nRet);
+	BLOCK_START
+	{
+		BREAK_IF(!m_data->isOpen());
+		BREAK_IF(fileName.empty());
 
-        nRet = unzOpenCurrentFile(m_data->zipFile);
-        BREAK_IF(UNZ_OK != nRet);
+		ZipFilePrivate::FileListContainer::const_iterator it = m_data->fileList.find(fileName);
+		BREAK_IF(it == m_data->fileList.end());
 
-        pBuffer = new unsigned char[fileInfo.uncompressed_size];
-        int nSize = unzReadCurrentFile(m_data->zipFile, pBuffer, (unsigned int)fileInfo.uncompressed_size);
-        AssertUnless(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "FileUtils: the file size is wrong.");
+		const ZipEntryInfo& fileInfo = it->second;
+		pBuffer = new unsigned char[(size_t)fileInfo.uncompressed_size];
+		if (!m_data->readEntry(fileInfo, pBuffer, nullptr))
+		{
+			Log("ZipFile: fail to read %s.", fileName);
+			delete [] pBuffer;
+			pBuffer = NULL;
+			break;
+		}
 
-        if (pSize)
-        {
-            *pSize = fileInfo.uncompressed_size;
-        }
-        unzCloseCurrentFile(m_data->zipFile);
-    }
+		if (pSize)
+		{
+			*pSize = (unsigned long)fileInfo.uncompressed_size;
+		}
+	}
 	BLOCK_END
 
-    return pBuffer;
+	return pBuffer;
 }
 
-void ZipFile::getFileDataByChunks(const std::string& fileName, const std::function<void(unsigned char*, int)>& handler)
+void ZipFile::getFileDataByChunks(const std::string& fileName, const std::function<void(unsigned char*, int)>& handler) const
 {
-    BLOCK_START
-    {
-        BREAK_IF(!m_data->zipFile);
-        BREAK_IF(fileName.empty());
-		
-		std::string file(fileName);
-
-        ZipFilePrivate::FileListContainer::const_iterator it = m_data->fileList.find(file);
-        BREAK_IF(it == m_data->fileList.end());
-
-        ZipEntryInfo fileInfo = it->second;
-
-        int nRet = unzGoToFilePos(m_data->zipFile, &fileInfo.pos);
-        BREAK_IF(UNZ_OK != nRet);
+	BLOCK_START
+	{
+		BREAK_IF(!m_data->isOpen());
+		BREAK_IF(fileName.empty());
 
-        nRet = unzOpenCurrentFile(m_data->zipFile);
-        BREAK_IF(UNZ_OK != nRet);
+		ZipFilePrivate::FileListContainer::const_iterator it = m_data->fileList.find(fileName);
+		BREAK_IF(it == m_data->fileList.end());
 
-        Uint8 buf[DORA_COPY_BUFFER_SIZE];
-		int nSize = 0, total = 0;
-		do
+		if (!m_data->readEntry(it->second, nullptr, handler))
 		{
-			nSize = unzReadCurrentFile(m_data->zipFile, buf, DORA_COPY_BUFFER_SIZE);
-			AssertIf(nSize < 0, "FileUtils: read current file error.");
-			if (nSize > 0)
-			{
-				handler(buf, nSize);
-			}
-			total += nSize;
+			Log("ZipFile: fail to read %s.", fileName);
 		}
-		while (nSize != 0);
-        AssertUnless(total == 0 || total == (int)fileInfo.uncompressed_size, "FileUtils: the file size is wrong.");
-        unzCloseCurrentFile(m_data->zipFile);
-    }
+	}
 	BLOCK_END
 }
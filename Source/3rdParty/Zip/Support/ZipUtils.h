@@ -36,6 +36,8 @@ class ZipFilePrivate;
 *
 * It will cache the file list of a particular zip file with positions inside an archive,
 * so it would be much faster to read some particular files or to check their existance.
+* Files are read with positional reads and inflated by the caller thread, so different
+* threads can read at the same time, only setFilter() should not run with reading.
 *
 * @since v2.0.5
 */
@@ -84,9 +86,9 @@ public:
 	*
 	* @since v2.0.5
 	*/
-	unsigned char* getFileData(const std::string&, unsigned long* size);
+	unsigned char* getFileData(const std::string&, unsigned long* size) const;
 
-	void getFileDataByChunks(const std::string& fileName, const std::function<void(unsigned char*,int)>& handler);
+	void getFileDataByChunks(const std::string& fileName, const std::function<void(unsigned char*,int)>& handler) const;
 
 	std::vector<std::string> getDirEntries(const std::string& path, bool isFolder);
 private:
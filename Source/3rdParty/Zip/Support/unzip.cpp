@@ -2155,3 +2155,15 @@ int ZEXPORT unzSetOffset (unzFile file, uLong pos)
 {
     return unzSetOffset64(file,pos);
 }
+
+ZPOS64_T ZEXPORT unzGetCurrentFileLocalHeaderOffset64 (unzFile file)
+{
+    unz64_s* s;
+
+    if (file==NULL)
+        return 0; //UNZ_PARAMERROR;
+    s=(unz64_s*)file;
+    if (!s->current_file_ok)
+        return 0;
+    return s->cur_file_info_internal.offset_curfile + s->byte_before_the_zipfile;
+}
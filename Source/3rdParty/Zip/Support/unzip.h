@@ -446,4 +446,8 @@ uLong unzGetOffset (unzFile file);
 int unzSetOffset64 (unzFile file, ZPOS64_T pos);
 int unzSetOffset (unzFile file, uLong pos);
 
+/* Get the offset of the local header of the current file in the zip file,
+   for readers accessing the entries without the unzFile handle */
+ZPOS64_T unzGetCurrentFileLocalHeaderOffset64 (unzFile file);
+
 #endif /* _unz64_H */
@@ -9,15 +9,32 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "Const/Header.h"
 #include "Basic/Application.h"
 #include "bx/timer.h"
+#include "bx/os.h"
+
+#if BX_PLATFORM_WINDOWS
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif // BX_PLATFORM_WINDOWS
 
 NS_DOROTHY_BEGIN
 
+// a 1ms sleep never takes less, and a sleep step is at most a quarter frame
+static const double MinSleepGranularity = 0.001;
+static const double MaxSleepFraction = 0.25;
+
 Application::Application():
-_width(800),
-_height(600),
+_frequency(double(bx::getHPFrequency())),
 _deltaTime(0),
 _updateTime(0),
-_frequency(double(bx::getHPFrequency()))
+_targetFPS(60),
+_pacingError(0),
+_averagePacingError(0),
+_idleTime(0),
+_sleepGranularity(0.002),
+_headless(false),
+_frameLimit(0),
+_width(800),
+_height(600)
 {
 	_lastTime = bx::getHPCounter() / _frequency;
 }
@@ -32,30 +49,57 @@ int Application::getHeight() const
 	return _height;
 }
 
+void Application::setHeadless(bool var)
+{
+	_headless = var;
+}
+
+bool Application::isHeadless() const
+{
+	return _headless;
+}
+
+void Application::setFrameLimit(int var)
+{
+	_frameLimit = max(var, 0);
+}
+
+int Application::getFrameLimit() const
+{
+	return _frameLimit;
+}
+
 // This function runs in main thread, and do render work
 int Application::run()
 {
-	if (SDL_Init(SDL_INIT_GAMECONTROLLER) != 0)
+	if (SDL_Init(_headless ? SDL_INIT_EVENTS : SDL_INIT_GAMECONTROLLER) != 0)
 	{
 		Log("SDL fail to initialize! %s", SDL_GetError());
 		return 1;
 	}
 
-	Uint32 windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI;
+	SDL_Window* window = nullptr;
+	if (!_headless)
+	{
+		Uint32 windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI;
 #if BX_PLATFORM_IOS || BX_PLATFORM_ANDROID
-	windowFlags |= SDL_WINDOW_FULLSCREEN;
+		windowFlags |= SDL_WINDOW_FULLSCREEN;
 #endif
-
-	SDL_Window* window = SDL_CreateWindow("Dorothy-SSR",
-		SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-		_width, _height, windowFlags);
-	if (!window)
-	{
-		Log("SDL fail to create window!");
-		return 1;
+		window = SDL_CreateWindow("Dorothy-SSR",
+			SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+			_width, _height, windowFlags);
+		if (!window)
+		{
+			Log("SDL fail to create window!");
+			return 1;
+		}
+		Application::setSdlWindow(window);
 	}
 
-	Application::setSdlWindow(window);
+#if BX_PLATFORM_WINDOWS
+	// raise the system timer resolution so that the frame pacer can sleep in 1ms steps
+	timeBeginPeriod(1);
+#endif
 
 	// call this function here to disable default render threads creation of bgfx
 	bgfx::renderFrame();
@@ -64,6 +108,7 @@ int Application::run()
 	_logicThread.init(Application::mainLogic, this);
 
 	SDL_Event event;
+	QMessage message;
 	bool running = true;
 	while (running)
 	{
@@ -81,17 +126,15 @@ int Application::run()
 			default:
 				break;
 			}
-			_logicEvent.post("SDLEvent", event);
+			_logicEvent.post(AppMessage::SDLEvent, event);
 		}
 
-		// poll events from logic thread
-		for (Own<QEvent> event = _renderEvent.poll();
-			event != nullptr;
-			event = _renderEvent.poll())
+		// poll messages from logic thread
+		while (_renderEvent.poll(message))
 		{
-			switch (Switch::hash(event->getName()))
+			switch (message.getId())
 			{
-				case "Quit"_hash:
+				case AppMessage::Quit:
 				{
 					SDL_Event ev;
 					ev.quit.type = SDL_QUIT;
@@ -107,10 +150,19 @@ int Application::run()
 	// wait for render process to stop
 	while (bgfx::RenderFrame::NoContext != bgfx::renderFrame());
 	_logicThread.shutdown();
+	// singletons made by the logic thread are destroyed by this thread at exit
+	Object::disableThreadCheck();
 
-	SDL_DestroyWindow(window);
+	if (window)
+	{
+		SDL_DestroyWindow(window);
+	}
 	SDL_Quit();
 
+#if BX_PLATFORM_WINDOWS
+	timeEndPeriod(1);
+#endif
+
 	return _logicThread.getExitCode();
 }
 
@@ -154,16 +206,80 @@ void Application::makeTimeNow()
 	_lastTime = bx::getHPCounter() / _frequency;
 }
 
+void Application::setTargetFPS(int var)
+{
+	_targetFPS = max(var, 0);
+}
+
+int Application::getTargetFPS() const
+{
+	return _targetFPS;
+}
+
+double Application::getPacingError() const
+{
+	return _pacingError;
+}
+
+double Application::getAveragePacingError() const
+{
+	return _averagePacingError;
+}
+
+double Application::getIdleTime() const
+{
+	return _idleTime;
+}
+
+void Application::waitForNextFrame()
+{
+	if (_targetFPS == 0)
+	{
+		_pacingError = 0;
+		_idleTime = 0;
+		return;
+	}
+	double startTime = bx::getHPCounter() / _frequency;
+	double frameTime = 1.0 / _targetFPS;
+	double targetTime = _lastTime + frameTime;
+	double currentTime = startTime;
+	// a single long oversleep from preemption must not stop the sleeping
+	double maxGranularity = frameTime * MaxSleepFraction;
+	// sleep in coarse steps while a whole sleep still fits before the target
+	while (targetTime - currentTime > _sleepGranularity)
+	{
+		bx::sleep(1);
+		double wakeTime = bx::getHPCounter() / _frequency;
+		// learn how long a 1ms sleep really takes on this system,
+		// jump up on oversleeps and only decay slowly
+		double slept = wakeTime - currentTime;
+		_sleepGranularity = min(maxGranularity, max(slept, _sleepGranularity * 0.95 + slept * 0.05));
+		currentTime = wakeTime;
+	}
+	if (currentTime == startTime)
+	{
+		_sleepGranularity = max(MinSleepGranularity, _sleepGranularity * 0.95);
+	}
+	_idleTime = currentTime - startTime;
+	// spin for the remaining fraction of a sleep step
+	while (currentTime < targetTime)
+	{
+		currentTime = bx::getHPCounter() / _frequency;
+	}
+	_pacingError = currentTime - targetTime;
+	_averagePacingError = _averagePacingError * 0.9 + std::abs(_pacingError) * 0.1;
+}
+
 void Application::shutdown()
 {
-	_renderEvent.post("Quit");
+	_renderEvent.post(AppMessage::Quit);
 }
 
 int Application::mainLogic(void* userData)
 {
 	Application* app = r_cast<Application*>(userData);
 	
-	if (!bgfx::init())
+	if (!bgfx::init(app->_headless ? bgfx::RendererType::Noop : bgfx::RendererType::Count))
 	{
 		Log("bgfx fail to initialize!");
 		return 1;
@@ -179,21 +295,23 @@ int Application::mainLogic(void* userData)
 
 	// Update and invoke render apis
 	app->updateDeltaTime();
+	QMessage message;
 	bool running = true;
+	int frames = 0;
+	double totalUpdateTime = 0;
+	double maxUpdateTime = 0;
 	while (running)
 	{
 		SharedPoolManager.push();
-		// poll events from render thread
-		for (Own<QEvent> event = app->_logicEvent.poll();
-			event != nullptr;
-			event = app->_logicEvent.poll())
+		// poll messages from render thread
+		while (app->_logicEvent.poll(message))
 		{
-			switch (Switch::hash(event->getName()))
+			switch (message.getId())
 			{
-				case "SDLEvent"_hash:
+				case AppMessage::SDLEvent:
 				{
 					SDL_Event sdlEvent;
-					EventQueue::retrieve(event, sdlEvent);
+					message.retrieve(sdlEvent);
 					switch (sdlEvent.type)
 					{
 						case SDL_QUIT:
@@ -213,18 +331,29 @@ int Application::mainLogic(void* userData)
 		SharedPoolManager.pop();
 
 		app->_updateTime = app->getEclapsedTime();
+		totalUpdateTime += app->_updateTime;
+		maxUpdateTime = max(maxUpdateTime, app->_updateTime);
+		if (++frames == app->_frameLimit)
+		{
+			app->shutdown();
+		}
 
 		// Advance to next frame. Rendering thread will be kicked to
 		// process submitted rendering primitives.
 		bgfx::frame();
 
-		// limit for 60 FPS
-		do {
-			app->updateDeltaTime();
-		} while (app->getDeltaTime() < 1.0/60);
+		// pace to the target frame rate
+		app->waitForNextFrame();
+		app->updateDeltaTime();
 		app->makeTimeNow();
 	}
 
+	if (app->_frameLimit > 0)
+	{
+		Print("[Dorothy Frame] frames %d, update time average %.3f ms, max %.3f ms\n",
+			frames, totalUpdateTime * 1000 / max(frames, 1), maxUpdateTime * 1000);
+	}
+
 	bgfx::shutdown();
 	return 0;
 }
@@ -239,6 +368,8 @@ TargetPlatform Application::getPlatform() const
 	return TargetPlatform::macOS;
 #elif BX_PLATFORM_IOS
 	return TargetPlatform::iOS;
+#elif BX_PLATFORM_LINUX
+	return TargetPlatform::Linux;
 #else
 	return TargetPlatform::Unknown;
 #endif
@@ -261,6 +392,9 @@ void Application::setSdlWindow(SDL_Window* window)
 	pd.ndt = nullptr;
 	pd.nwh = wmi.info.android.window;
 	SDL_GL_GetDrawableSize(window, &_width, &_height);
+#elif BX_PLATFORM_LINUX && defined(SDL_VIDEO_DRIVER_X11)
+	pd.ndt = wmi.info.x11.display;
+	pd.nwh = r_cast<void*>(wmi.info.x11.window);
 #endif
 	pd.context = nullptr;
 	pd.backBuffer = nullptr;
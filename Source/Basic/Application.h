@@ -18,10 +18,19 @@ ENUM_START(TargetPlatform)
 	Android,
 	macOS,
 	iOS,
+	Linux,
 	Unknown
 }
 ENUM_END(TargetPlatform)
 
+/** @brief Ids of messages passed between the render and logic thread. */
+ENUM_START(AppMessage)
+{
+	SDLEvent = 1,
+	Quit
+}
+ENUM_END(AppMessage)
+
 class Application : public Object
 {
 public:
@@ -32,6 +41,20 @@ public:
 	PROPERTY_READONLY(double, EclapsedTime);
 	PROPERTY_READONLY(double, UpdateTime);
 	PROPERTY_READONLY(TargetPlatform, Platform);
+	/** @brief Frames per second the logic thread is paced to, 0 for unlimited. */
+	PROPERTY_NAME(int, TargetFPS);
+	/** @brief Time the last frame ended later than it was scheduled to. */
+	PROPERTY_READONLY(double, PacingError);
+	/** @brief Moving average of the absolute frame pacing error. */
+	PROPERTY_READONLY(double, AveragePacingError);
+	/** @brief Time the logic thread slept while waiting for the last frame. */
+	PROPERTY_READONLY(double, IdleTime);
+	/** @brief Run without a window and render with the Noop renderer of bgfx,
+	 for running logic and scripts on machines without GPU. Set before run. */
+	PROPERTY_BOOL_NAME(Headless);
+	/** @brief Quit after the count of frames and print the frame time statistics,
+	 0 for running until quit. Set before run. */
+	PROPERTY_NAME(int, FrameLimit);
 	Application();
 	int run();
 	void shutdown();
@@ -39,12 +62,20 @@ public:
 protected:
 	void updateDeltaTime();
 	void makeTimeNow();
+	void waitForNextFrame();
 	void setSdlWindow(SDL_Window* window);
 	const double _frequency;
 	bx::Thread _logicThread;
 	double _lastTime;
 	double _deltaTime;
 	double _updateTime;
+	int _targetFPS;
+	double _pacingError;
+	double _averagePacingError;
+	double _idleTime;
+	double _sleepGranularity;
+	bool _headless;
+	int _frameLimit;
 	int _width;
 	int _height;
 	EventQueue _logicEvent;
@@ -11,15 +11,32 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
+PoolManager::PoolManager():
+_frameAutoreleaseCount(0),
+_autoreleaseCount(0),
+_maxAutoreleaseCount(0)
+{ }
+
+int PoolManager::getAutoreleaseCount() const
+{
+	return _autoreleaseCount;
+}
+
+int PoolManager::getMaxAutoreleaseCount() const
+{
+	return _maxAutoreleaseCount;
+}
+
 void PoolManager::clear()
 {
 	stack<Ref<AutoreleasePool>> emptyStack;
 	_releasePoolStack.swap(emptyStack);
+	_frameArena.reset();
 }
 
 void PoolManager::push()
 {
-	AutoreleasePool* pool = new AutoreleasePool();
+	AutoreleasePool* pool = new AutoreleasePool(_frameArena.getMarker());
 	_releasePoolStack.push(RefMake(pool));
 	pool->release();
 }
@@ -28,7 +45,16 @@ void PoolManager::pop()
 {
 	if (!_releasePoolStack.empty())
 	{
+		FrameArena::Marker marker = _releasePoolStack.top()->getArenaMarker();
 		_releasePoolStack.pop();
+		_frameArena.rewind(marker);
+		// the outermost pool is popped at the end of each frame
+		if (_releasePoolStack.empty())
+		{
+			_autoreleaseCount = _frameAutoreleaseCount;
+			_maxAutoreleaseCount = max(_maxAutoreleaseCount, _autoreleaseCount);
+			_frameAutoreleaseCount = 0;
+		}
 	}
 }
 
@@ -42,39 +68,66 @@ void PoolManager::addObject(Object* object)
 {
 	AssertIf(_releasePoolStack.empty(), "current auto release pool stack should not be empty.");
 	_releasePoolStack.top()->addObject(object);
+	_frameAutoreleaseCount++;
+}
+
+FrameArena& PoolManager::getFrameArena()
+{
+	return _frameArena;
 }
 
+PoolManager::AutoreleasePool::AutoreleasePool(const FrameArena::Marker& arenaMarker):
+_arenaMarker(arenaMarker)
+{ }
 
 PoolManager::AutoreleasePool::~AutoreleasePool()
 {
 	AutoreleasePool::clear();
 }
 
+const FrameArena::Marker& PoolManager::AutoreleasePool::getArenaMarker() const
+{
+	return _arenaMarker;
+}
+
 void PoolManager::AutoreleasePool::addObject(Object* object)
 {
-	_managedObjects.push_back(object);
-	AssertUnless(object->getRefCount() > 1, "reference count should be greater than 1.");
+	// take over the reference of the caller
+	AssertUnless(object->getRefCount() > 0, "reference count should be greater than 0.");
 	object->_managed = true;
-	object->release();
+	object->_managedIndex = s_cast<Uint32>(_managedObjects.size());
+	_managedObjects.push_back(object);
 }
 
 void PoolManager::AutoreleasePool::removeObject(Object* object)
 {
-	Ref<Object> objectRef(object);
-	if (_managedObjects.fast_remove(object))
+	// give the reference back to the caller,
+	// an object managed by another pool is not in this one
+	Uint32 index = object->_managedIndex;
+	if (object->_managed && index < _managedObjects.size() && _managedObjects[index] == object)
 	{
+		Object* last = _managedObjects.back();
+		_managedObjects[index] = last;
+		last->_managedIndex = index;
+		_managedObjects.pop_back();
 		object->_managed = false;
-		object->retain();
 	}
 }
 
 void PoolManager::AutoreleasePool::clear()
 {
-	for (Object* object : _managedObjects)
+	// objects may be autoreleased again by the destructors of the released ones
+	vector<Object*> managedObjects;
+	while (!_managedObjects.empty())
 	{
-		object->_managed = false;
+		managedObjects.swap(_managedObjects);
+		for (Object* object : managedObjects)
+		{
+			object->_managed = false;
+			object->release();
+		}
+		managedObjects.clear();
 	}
-	_managedObjects.clear();
 }
 
 NS_DOROTHY_END
@@ -18,18 +18,32 @@ public:
 	void clear();
 	void removeObject(Object* object);
 	void addObject(Object* object);
+	/** @brief Count of objects autoreleased in the last frame. */
+	PROPERTY_READONLY(int, AutoreleaseCount);
+	PROPERTY_READONLY(int, MaxAutoreleaseCount);
+	PoolManager();
+	/** @brief Arena for transient data, rewound when the current pool pops. */
+	FrameArena& getFrameArena();
 private:
 	class AutoreleasePool : public Object
 	{
 	public:
+		AutoreleasePool(const FrameArena::Marker& arenaMarker);
 		virtual ~AutoreleasePool();
+		const FrameArena::Marker& getArenaMarker() const;
 		void addObject(Object* object);
 		void removeObject(Object* object);
 		void clear();
 	private:
-		RefVector<Object> _managedObjects;
+		// the pool owns one reference of each object
+		vector<Object*> _managedObjects;
+		FrameArena::Marker _arenaMarker;
 	};
 	stack<Ref<AutoreleasePool>> _releasePoolStack;
+	int _frameAutoreleaseCount;
+	int _autoreleaseCount;
+	int _maxAutoreleaseCount;
+	FrameArena _frameArena;
 };
 
 #define SharedPoolManager \
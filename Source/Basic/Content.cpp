@@ -13,6 +13,16 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <fstream>
 using std::ofstream;
 
+#if BX_PLATFORM_OSX || BX_PLATFORM_IOS || BX_PLATFORM_ANDROID || BX_PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define DORA_FILE_MAPPING 1
+#else
+#define DORA_FILE_MAPPING 0
+#endif
+
 #if BX_PLATFORM_WINDOWS
 #include <Shlobj.h>
 #endif // BX_PLATFORM_WINDOWS
@@ -20,20 +30,191 @@ using std::ofstream;
 #if BX_PLATFORM_ANDROID
 #include "Zip/Support/ZipUtils.h"
 #include "Basic/AndroidMain.h"
+// the apk file is read with positional reads, safe for workers at the same time
 static Dorothy::Own<ZipFile> g_apkFile;
 #endif // BX_PLATFORM_ANDROID
 
 NS_DOROTHY_BEGIN
 
+FileView::FileView():
+_data(nullptr),
+_size(0),
+_mapped(false)
+{ }
+
+FileView::FileView(Uint8* buffer, Sint64 size):
+_data(buffer),
+_size(size),
+_mapped(false)
+{ }
+
+FileView::FileView(FileView* owner, Sint64 offset, Sint64 size):
+_data(owner->_data + offset),
+_size(size),
+_mapped(false),
+_owner(owner)
+{ }
+
+FileView::~FileView()
+{
+	if (_owner)
+	{
+		return;
+	}
+#if DORA_FILE_MAPPING
+	if (_mapped)
+	{
+		munmap(_data, s_cast<size_t>(_size));
+		return;
+	}
+#endif // DORA_FILE_MAPPING
+	delete [] _data;
+}
+
+FileView* FileView::map(const string& fullPath)
+{
+#if DORA_FILE_MAPPING
+	int fd = open(fullPath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+	FileView* view = nullptr;
+	struct stat buf;
+	if (fstat(fd, &buf) == 0 && S_ISREG(buf.st_mode))
+	{
+		if (buf.st_size == 0)
+		{
+			// an empty file can not be mapped
+			view = new FileView();
+		}
+		else
+		{
+			void* data = mmap(nullptr, s_cast<size_t>(buf.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED)
+			{
+				view = new FileView();
+				view->_data = s_cast<Uint8*>(data);
+				view->_size = buf.st_size;
+				view->_mapped = true;
+			}
+		}
+	}
+	// the mapping stays valid after the file is closed
+	close(fd);
+	return view;
+#else
+	DORA_UNUSED_PARAM(fullPath);
+	return nullptr;
+#endif // DORA_FILE_MAPPING
+}
+
 Content::~Content()
 { }
 
+// files are written to a temp file then renamed over the target, so that loaders
+// and mapped views never see a truncated or partly written file
+static bool writeFile(const string& fullPath, const function<bool(ofstream&)>& write)
+{
+	static std::atomic<Uint32> tempCount(0);
+	string tempPath = fullPath + ".tmp" + std::to_string(++tempCount);
+	bool result = false;
+	{
+		ofstream stream(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+		result = stream && write(stream);
+	}
+	if (result)
+	{
+#if BX_PLATFORM_WINDOWS
+		result = MoveFileExA(tempPath.c_str(), fullPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		result = ::rename(tempPath.c_str(), fullPath.c_str()) == 0;
+#endif // BX_PLATFORM_WINDOWS
+	}
+	if (!result)
+	{
+		::remove(tempPath.c_str());
+	}
+	return result;
+}
+
+void Content::loadPackEntryByChunks(Pack* pack, String entryName, const function<void(Uint8*,int)>& handler)
+{
+	Ref<FileView> view = pack->load(entryName);
+	if (!view)
+	{
+		Log("fail to load file: %s", entryName);
+		return;
+	}
+	// handlers may write to the chunk, pass copies of the read only data
+	Uint8 buffer[DORA_COPY_BUFFER_SIZE];
+	for (size_t offset = 0; offset < view->size(); offset += DORA_COPY_BUFFER_SIZE)
+	{
+		int size = s_cast<int>(min(view->size() - offset, s_cast<size_t>(DORA_COPY_BUFFER_SIZE)));
+		memcpy(buffer, view->rawData() + offset, size);
+		handler(buffer, size);
+	}
+}
+
 OwnArray<Uint8> Content::loadFile(String filename, Sint64& size)
 {
-	Async::FileIO.pause();
-	Uint8* data = Content::loadFileUnsafe(filename, size);
-	Async::FileIO.resume();
-	return OwnArray<Uint8>(data);
+	// reading is safe along with the file workers, no need to pause them
+	return OwnArray<Uint8>(Content::loadFileUnsafe(filename, size));
+}
+
+Ref<FileView> Content::mapFile(String filename)
+{
+	return Content::mapFileUnsafe(filename);
+}
+
+Ref<FileView> Content::mapFileUnsafe(String filename)
+{
+	if (filename.empty())
+	{
+		return Ref<FileView>();
+	}
+	string fullPath = Content::getFullPath(filename);
+	string entryName;
+	Ref<Pack> pack = Content::getPack(fullPath, entryName);
+	if (pack)
+	{
+		return pack->load(entryName);
+	}
+	Ref<FileView> view;
+#if BX_PLATFORM_ANDROID
+	// files in apk are compressed, they can only be loaded
+	if (fullPath[0] == '/')
+	{
+		view = FileView::map(fullPath);
+	}
+#else
+	view = FileView::map(fullPath);
+#endif // BX_PLATFORM_ANDROID
+	if (!view)
+	{
+		Sint64 size = 0;
+		Uint8* data = Content::loadFileUnsafe(filename, size);
+		if (data)
+		{
+			view = new FileView(data, size);
+		}
+	}
+	return view;
+}
+
+Ref<Pack> Content::getPack(const string& fullPath, string& entryName)
+{
+	bx::MutexScope lock(_pathMutex);
+	for (const auto& it : _packs)
+	{
+		const string& packPath = it.first;
+		if (fullPath.size() > packPath.size() && fullPath.compare(0, packPath.size(), packPath) == 0)
+		{
+			entryName = fullPath.substr(packPath.size());
+			return it.second;
+		}
+	}
+	return Ref<Pack>();
 }
 
 void Content::copyFile(String src, String dst)
@@ -45,20 +226,36 @@ void Content::copyFile(String src, String dst)
 
 void Content::saveToFile(String filename, String content)
 {
-	ofstream stream(Content::getFullPath(filename), std::ios::trunc | std::ios::binary);
-	stream.write(content.rawData(), content.size());
+	string fullPath = Content::getFullPath(filename);
+	if (!writeFile(fullPath, [&](ofstream& stream)
+	{
+		return !stream.write(content.rawData(), content.size()).fail();
+	}))
+	{
+		Log("fail to save file: %s", fullPath);
+	}
+	Content::invalidatePath(fullPath);
 }
 
 void Content::saveToFile(String filename, Uint8* content, Sint64 size)
 {
-	ofstream stream(Content::getFullPath(filename), std::ios::trunc | std::ios::binary);
-	stream.write(r_cast<char*>(content), size);
+	string fullPath = Content::getFullPath(filename);
+	if (!writeFile(fullPath, [&](ofstream& stream)
+	{
+		return !stream.write(r_cast<char*>(content), size).fail();
+	}))
+	{
+		Log("fail to save file: %s", fullPath);
+	}
+	Content::invalidatePath(fullPath);
 }
 
 bool Content::removeFile(String filename)
 {
 	string fullpath = Content::getFullPath(filename);
-	return ::remove(fullpath.c_str()) == 0 || RMDIR(fullpath.c_str()) == 0;
+	bool result = ::remove(fullpath.c_str()) == 0 || RMDIR(fullpath.c_str()) == 0;
+	Content::invalidatePath(fullpath);
+	return result;
 }
 
 bool Content::createFolder(String path)
@@ -92,6 +289,7 @@ bool Content::createFolder(String path)
 				{
 					return false;
 				}
+				Content::invalidatePath(pszDir);
 			}
 			pszDir[i] = '/';
 		}
@@ -132,10 +330,111 @@ string Content::getFullPath(String filename)
 		return targetFile;
 	}
 
-	auto it  = _fullPathCache.find(targetFile);
-	if (it != _fullPathCache.end())
+	string fullPath = Content::resolvePath(targetFile);
+	return fullPath.empty() ? targetFile.toString() : fullPath;
+}
+
+bool Content::hasFile(String filename)
+{
+	if (filename.empty())
 	{
-		return it->second;
+		return false;
+	}
+	Slice targetFile = filename;
+	if (filename[0] == '.' && (filename[1] == '/' || filename[1] == '\\'))
+	{
+		targetFile.skip(2);
+	}
+	return !Content::resolvePath(targetFile).empty();
+}
+
+bool Content::isFileExist(String filePath)
+{
+	if (filePath.empty())
+	{
+		return false;
+	}
+	if (Content::isAbsolutePath(filePath))
+	{
+		return !Content::resolvePath(filePath).empty();
+	}
+	return !Content::resolvePath(_currentPath + filePath).empty();
+}
+
+bool Content::isFolder(String path)
+{
+	if (path.empty())
+	{
+		return false;
+	}
+	string folder = path;
+	Uint32 changes;
+	{
+		bx::MutexScope lock(_pathMutex);
+		auto it = _folderCache.find(folder);
+		if (it != _folderCache.end())
+		{
+			return it->second;
+		}
+		changes = _pathChanges;
+	}
+	string entryName;
+	Ref<Pack> pack = Content::getPack(folder, entryName);
+	bool result = pack ? pack->isFolder(entryName) : Content::checkFolder(folder);
+	bx::MutexScope lock(_pathMutex);
+	if (changes == _pathChanges)
+	{
+		_folderCache[folder] = result;
+	}
+	return result;
+}
+
+string Content::resolvePath(const string& targetFile)
+{
+	// path resolving is shared by logic thread and workers
+	Uint32 changes;
+	vector<std::pair<string, Ref<Pack>>> searchPaths;
+	{
+		bx::MutexScope lock(_pathMutex);
+		auto it = _fullPathCache.find(targetFile);
+		if (it != _fullPathCache.end())
+		{
+			return it->second;
+		}
+		changes = _pathChanges;
+		++_searching;
+		searchPaths.reserve(_searchPaths.size());
+		for (const string& searchPath : _searchPaths)
+		{
+			auto pack = _packs.find(searchPath);
+			searchPaths.emplace_back(searchPath, pack != _packs.end() ? pack->second : Ref<Pack>());
+		}
+	}
+	// search the file system without the lock, so that workers are not serialized by disk accesses
+	string fullPath = Content::findPath(targetFile, searchPaths);
+	bx::MutexScope lock(_pathMutex);
+	--_searching;
+	// the result may be stale when paths are changed while searching
+	if (changes == _pathChanges)
+	{
+		_fullPathCache[targetFile] = fullPath;
+	}
+	return fullPath;
+}
+
+string Content::findPath(const string& targetFile, const vector<std::pair<string, Ref<Pack>>>& searchPaths)
+{
+	if (Content::isAbsolutePath(targetFile))
+	{
+		for (const auto& searchPath : searchPaths)
+		{
+			const string& packPath = searchPath.first;
+			if (searchPath.second && targetFile.size() > packPath.size() && targetFile.compare(0, packPath.size(), packPath) == 0)
+			{
+				return searchPath.second->hasEntry(targetFile.substr(packPath.size())) ? targetFile : string();
+			}
+		}
+		return Content::checkFileExist(targetFile) ? targetFile : string();
 	}
 
 	string path, file;
@@ -143,36 +442,126 @@ string Content::getFullPath(String filename)
 	string fullPath = Content::getFullPathForDirectoryAndFilename(path, file);
 	if (!fullPath.empty())
 	{
-		_fullPathCache[targetFile] = fullPath;
 		return fullPath;
 	}
 
-	for (const string& searchPath : _searchPaths)
+	for (const auto& searchPath : searchPaths)
 	{
-		std::tie(path, file) = splitDirectoryAndFilename(searchPath + targetFile);
+		if (searchPath.second)
+		{
+			if (searchPath.second->hasEntry(targetFile))
+			{
+				return searchPath.first + targetFile;
+			}
+			continue;
+		}
+		std::tie(path, file) = splitDirectoryAndFilename(searchPath.first + targetFile);
 		fullPath = Content::getFullPathForDirectoryAndFilename(path, file);
 		if (!fullPath.empty())
 		{
-			_fullPathCache[targetFile] = fullPath;
 			return fullPath;
 		}
 	}
+	return string();
+}
 
-	return targetFile;
+static inline bool isSeparator(char ch)
+{
+	return ch == '/' || ch == '\\';
+}
+
+// whether a cached answer of the key may change by a change of the file or folder at the path
+static bool isPathAffected(const string& key, const string& fullPath, const string& path)
+{
+	// found in the path or under the path
+	if (fullPath.compare(0, path.size(), path) == 0 && (fullPath.size() == path.size() || isSeparator(fullPath[path.size()])))
+	{
+		return true;
+	}
+	// the key or a folder of the key resolves to the path from some search path
+	for (size_t size = 1; size <= key.size(); size++)
+	{
+		if (size < key.size() && !isSeparator(key[size]))
+		{
+			continue;
+		}
+		if (size <= path.size() && path.compare(path.size() - size, size, key, 0, size) == 0
+			&& (size == path.size() || isSeparator(path[path.size() - size - 1])))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void Content::invalidatePath(const string& path)
+{
+	string target = path;
+	while (target.size() > 1 && isSeparator(target.back()))
+	{
+		target.pop_back();
+	}
+	bx::MutexScope lock(_pathMutex);
+	++_pathChanges;
+	bool changed = false;
+	for (auto it = _fullPathCache.begin(); it != _fullPathCache.end();)
+	{
+		if (isPathAffected(it->first, it->second, target))
+		{
+			it = _fullPathCache.erase(it);
+			changed = true;
+		}
+		else ++it;
+	}
+	for (auto it = _folderCache.begin(); it != _folderCache.end();)
+	{
+		if (isPathAffected(it->first, it->first, target)) it = _folderCache.erase(it);
+		else ++it;
+	}
+	// a search running now may return a stale answer, caches of the answers
+	// out of Content are told by the version even when no entry is dropped
+	if (changed || _searching > 0)
+	{
+		++_pathVersion;
+	}
+}
+
+void Content::clearPathCache()
+{
+	bx::MutexScope lock(_pathMutex);
+	_fullPathCache.clear();
+	_folderCache.clear();
+	++_pathChanges;
+	++_pathVersion;
+}
+
+Uint32 Content::getPathVersion() const
+{
+	return _pathVersion.load(std::memory_order_relaxed);
 }
 
 void Content::addSearchPath(String path)
 {
+	bx::MutexScope lock(_pathMutex);
 	string searchPath = (Content::isAbsolutePath(path) ? "" : _currentPath) + path;
 	if (searchPath.length() > 0 && (searchPath.back() != '/' && searchPath.back() != '\\'))
 	{
 		searchPath += "/";
 	}
 	_searchPaths.push_back(searchPath);
+	// found files are still found first, only files not found may be in the new path
+	for (auto it = _fullPathCache.begin(); it != _fullPathCache.end();)
+	{
+		if (it->second.empty()) it = _fullPathCache.erase(it);
+		else ++it;
+	}
+	++_pathChanges;
+	++_pathVersion;
 }
 
 void Content::removeSearchPath(String path)
 {
+	bx::MutexScope lock(_pathMutex);
 	string realPath = (Content::isAbsolutePath(path) ? "" : _currentPath) + path;
 	if (realPath.length() > 0 && (realPath.back() != '/' && realPath.back() != '\\'))
 	{
@@ -183,7 +572,18 @@ void Content::removeSearchPath(String path)
 		if (*it == realPath)
 		{
 			_searchPaths.erase(it);
-			_fullPathCache.clear();
+			if (_packs.erase(realPath) > 0)
+			{
+				_folderCache.clear();
+			}
+			// files not found are still not found, found files may be in the removed path
+			for (auto cacheIt = _fullPathCache.begin(); cacheIt != _fullPathCache.end();)
+			{
+				if (cacheIt->second.empty()) ++cacheIt;
+				else cacheIt = _fullPathCache.erase(cacheIt);
+			}
+			++_pathChanges;
+			++_pathVersion;
 			break;
 		}
 	}
@@ -191,14 +591,52 @@ void Content::removeSearchPath(String path)
 
 void Content::setSearchPaths(const vector<string>& searchPaths)
 {
+	bx::MutexScope lock(_pathMutex);
 	_searchPaths.clear();
 	_fullPathCache.clear();
+	_folderCache.clear();
+	_packs.clear();
+	++_pathChanges;
+	++_pathVersion;
 	for (const string& searchPath : searchPaths)
 	{
 		Content::addSearchPath(searchPath);
 	}
 }
 
+bool Content::mountPack(String packFile)
+{
+	string fullPath = Content::getFullPath(packFile);
+	Ref<FileView> file = Content::mapFile(fullPath);
+	Ref<Pack> pack(Pack::open(file));
+	if (!pack)
+	{
+		Log("fail to mount pack: %s", packFile);
+		return false;
+	}
+	bx::MutexScope lock(_pathMutex);
+	string packPath = fullPath + '/';
+	if (_packs.find(packPath) == _packs.end())
+	{
+		_packs[packPath] = pack;
+		_searchPaths.push_back(packPath);
+		for (auto it = _fullPathCache.begin(); it != _fullPathCache.end();)
+		{
+			if (it->second.empty()) it = _fullPathCache.erase(it);
+			else ++it;
+		}
+		_folderCache.clear();
+		++_pathChanges;
+		++_pathVersion;
+	}
+	return true;
+}
+
+void Content::unmountPack(String packFile)
+{
+	Content::removeSearchPath(Content::getFullPath(packFile));
+}
+
 void Content::copyFileUnsafe(String src, String dst)
 {
 	string srcPath = Content::getFullPath(src);
@@ -228,27 +666,34 @@ void Content::copyFileUnsafe(String src, String dst)
 		for (const string& file : files)
 		{
 			// LOG("now copy file %s",file);
-			ofstream stream((dstPath + '/' + file), std::ios::out | std::ios::trunc | std::ios::binary);
-			Content::loadFileByChunks((srcPath + '/' + file), [&](Uint8* buffer, int size)
+			writeFile(dstPath + '/' + file, [&](ofstream& stream)
 			{
-				if (!stream.write(r_cast<char*>(buffer), size))
+				Content::loadFileByChunks((srcPath + '/' + file), [&](Uint8* buffer, int size)
 				{
-					Log("write file failed! %s", dstPath + '/' + file);
-				}
+					if (!stream.write(r_cast<char*>(buffer), size))
+					{
+						Log("write file failed! %s", dstPath + '/' + file);
+					}
+				});
+				return !stream.fail();
 			});
 		}
 	}
 	else
 	{
-		ofstream stream(dst, std::ios::out | std::ios::trunc | std::ios::binary);
-		Content::loadFileByChunks(src, [&](Uint8* buffer, int size)
+		writeFile(dst, [&](ofstream& stream)
 		{
-			if (!stream.write(r_cast<char*>(buffer), size))
+			Content::loadFileByChunks(src, [&](Uint8* buffer, int size)
 			{
-				Log("write file failed! %s", dst);
-			}
+				if (!stream.write(r_cast<char*>(buffer), size))
+				{
+					Log("write file failed! %s", dst);
+				}
+			});
+			return !stream.fail();
 		});
 	}
+	Content::invalidatePath(dst);
 }
 
 void Content::loadFileAsyncUnsafe(String filename, const function<void (Uint8*, Sint64)>& callback)
@@ -258,15 +703,11 @@ void Content::loadFileAsyncUnsafe(String filename, const function<void (Uint8*,
 	{
 		Sint64 size;
 		Uint8* buffer = this->loadFileUnsafe(fileStr, size);
-		return new std::tuple<Uint8*,Sint64>(buffer,size);
-	},
-	[callback](void* result)
+		return std::make_tuple(buffer, size);
+	})
+	.then([callback](std::tuple<Uint8*,Sint64>& result)
 	{
-		Uint8* buffer;
-		Sint64 size;
-		auto data = OwnMake((std::tuple<Uint8*,Sint64>*)result);
-		std::tie(buffer,size) = *data;
-		callback(buffer,size);
+		callback(std::get<0>(result), std::get<1>(result));
 	});
 }
 
@@ -278,19 +719,27 @@ void Content::loadFileAsync(String filename, const function<void (OwnArray<Uint8
 	});
 }
 
+void Content::mapFileAsync(String filename, const function<void(Ref<FileView>)>& callback)
+{
+	string fileStr = filename;
+	Async::FileIO.run([fileStr, this]()
+	{
+		return this->mapFileUnsafe(fileStr);
+	})
+	.then([callback](Ref<FileView>& view)
+	{
+		callback(view);
+	});
+}
+
 void Content::copyFileAsync(String src, String dst, const function<void()>& callback)
 {
 	string srcFile(src), dstFile(dst);
 	Async::FileIO.run([srcFile,dstFile,this]()
 	{
 		Content::copyFileUnsafe(srcFile, dstFile);
-		return nullptr;
-	},
-	[callback](void* result)
-	{
-		DORA_UNUSED_PARAM(result);
-		callback();
-	});
+	})
+	.then(callback);
 }
 
 void Content::saveToFileAsync(String filename, String content, const function<void()>& callback)
@@ -300,13 +749,8 @@ void Content::saveToFileAsync(String filename, String content, const function<vo
 	Async::FileIO.run([file,data,this]()
 	{
 		Content::saveToFile(file, *OwnMake(data));
-		return nullptr;
-	},
-	[callback](void* result)
-	{
-		DORA_UNUSED_PARAM(result);
-		callback();
-	});
+	})
+	.then(callback);
 }
 
 void Content::saveToFileAsync(String filename, OwnArray<Uint8> content, Sint64 size, const function<void()>& callback)
@@ -316,13 +760,8 @@ void Content::saveToFileAsync(String filename, OwnArray<Uint8> content, Sint64 s
 	Async::FileIO.run([file,data,size,this]()
 	{
 		Content::saveToFile(file, *OwnMake(data).get(), size);
-		return nullptr;
-	},
-	[callback](void* result)
-	{
-		DORA_UNUSED_PARAM(result);
-		callback();
-	});
+	})
+	.then(callback);
 }
 
 vector<string> Content::getDirEntries(String path, bool isFolder)
@@ -365,7 +804,10 @@ vector<string> Content::getDirEntries(String path, bool isFolder)
 }
 
 #if BX_PLATFORM_ANDROID
-Content::Content()
+Content::Content():
+_pathVersion(0),
+_pathChanges(0),
+_searching(0)
 {
 	_currentPath = "assets/";
 	g_apkFile = OwnNew<ZipFile>(getAndroidAPKPath(), _currentPath);
@@ -383,9 +825,17 @@ Uint8* Content::loadFileUnsafe(String filename, Sint64& size)
 		return data;
 	}
 	string fullPath = Content::getFullPath(filename);
-	if (fullPath[0] != '/')
+	string entryName;
+	Ref<Pack> pack = Content::getPack(fullPath, entryName);
+	if (pack)
+	{
+		data = pack->loadData(entryName, size);
+	}
+	else if (fullPath[0] != '/')
 	{
-		data = g_apkFile->getFileData(fullPath, r_cast<unsigned long*>(&size));
+		unsigned long dataSize = 0;
+		data = g_apkFile->getFileData(fullPath, &dataSize);
+		size = s_cast<Sint64>(dataSize);
 	}
 	else
 	{
@@ -420,7 +870,13 @@ void Content::loadFileByChunks(String filename, const std::function<void(Uint8*,
 		return;
 	}
 	string fullPath = Content::getFullPath(filename);
-	if (fullPath[0] != '/')
+	string entryName;
+	Ref<Pack> pack = Content::getPack(fullPath, entryName);
+	if (pack)
+	{
+		Content::loadPackEntryByChunks(pack, entryName, handler);
+	}
+	else if (fullPath[0] != '/')
 	{
 		g_apkFile->getFileDataByChunks(fullPath, handler);
 	}
@@ -447,7 +903,7 @@ void Content::loadFileByChunks(String filename, const std::function<void(Uint8*,
 	}
 }
 
-bool Content::isFileExist(String strFilePath)
+bool Content::checkFileExist(String strFilePath)
 {
 	if (strFilePath.empty())
 	{
@@ -480,7 +936,7 @@ bool Content::isFileExist(String strFilePath)
 	return found;
 }
 
-bool Content::isFolder(String path)
+bool Content::checkFolder(String path)
 {
 	return g_apkFile->isFolder(path);
 }
@@ -500,7 +956,10 @@ bool Content::isAbsolutePath(String strPath)
 #endif // BX_PLATFORM_ANDROID
 
 #if BX_PLATFORM_WINDOWS
-Content::Content()
+Content::Content():
+_pathVersion(0),
+_pathChanges(0),
+_searching(0)
 {
 	char currentPath[MAX_PATH] = {0};
 	GetCurrentDirectory(sizeof(currentPath), currentPath);
@@ -511,7 +970,7 @@ Content::Content()
 	SDL_free(prefPath);
 }
 
-bool Content::isFileExist(String filePath)
+bool Content::checkFileExist(String filePath)
 {
 	string strPath = filePath;
 	if (!Content::isAbsolutePath(strPath))
@@ -533,8 +992,29 @@ bool Content::isAbsolutePath(String strPath)
 }
 #endif // BX_PLATFORM_WINDOWS
 
-#if BX_PLATFORM_OSX || BX_PLATFORM_IOS
-Content::Content()
+#if BX_PLATFORM_LINUX
+bool Content::checkFileExist(String filePath)
+{
+	string strPath = filePath;
+	if (!Content::isAbsolutePath(strPath))
+	{
+		strPath.insert(0, _currentPath);
+	}
+	struct stat buf;
+	return ::stat(strPath.c_str(), &buf) == 0;
+}
+
+bool Content::isAbsolutePath(String strPath)
+{
+	return !strPath.empty() && strPath[0] == '/';
+}
+#endif // BX_PLATFORM_LINUX
+
+#if BX_PLATFORM_OSX || BX_PLATFORM_IOS || BX_PLATFORM_LINUX
+Content::Content():
+_pathVersion(0),
+_pathChanges(0),
+_searching(0)
 {
 	char* currentPath = SDL_GetBasePath();
 	_currentPath = currentPath;
@@ -544,13 +1024,21 @@ Content::Content()
 	_writablePath = prefPath;
 	SDL_free(prefPath);
 }
-#endif // BX_PLATFORM_OSX || BX_PLATFORM_IOS
+#endif // BX_PLATFORM_OSX || BX_PLATFORM_IOS || BX_PLATFORM_LINUX
 
-#if BX_PLATFORM_WINDOWS || BX_PLATFORM_OSX || BX_PLATFORM_IOS
+#if BX_PLATFORM_WINDOWS || BX_PLATFORM_OSX || BX_PLATFORM_IOS || BX_PLATFORM_LINUX
 Uint8* Content::loadFileUnsafe(String filename, Sint64& size)
 {
 	if (filename.empty()) return nullptr;
 	string fullPath = Content::getFullPath(filename);
+	string entryName;
+	Ref<Pack> pack = Content::getPack(fullPath, entryName);
+	if (pack)
+	{
+		Uint8* data = pack->loadData(entryName, size);
+		if (!data) Log("fail to load file: %s", filename);
+		return data;
+	}
 	SDL_RWops* io = SDL_RWFromFile(fullPath.c_str(), "rb");
 	if (io == nullptr)
 	{
@@ -568,6 +1056,13 @@ void Content::loadFileByChunks(String filename, const std::function<void(Uint8*,
 {
 	if (filename.empty()) return;
 	string fullPath = Content::getFullPath(filename);
+	string entryName;
+	Ref<Pack> pack = Content::getPack(fullPath, entryName);
+	if (pack)
+	{
+		Content::loadPackEntryByChunks(pack, entryName, handler);
+		return;
+	}
 	SDL_RWops* io = SDL_RWFromFile(fullPath.c_str(), "rb");
 	if (io == nullptr)
 	{
@@ -583,7 +1078,7 @@ void Content::loadFileByChunks(String filename, const std::function<void(Uint8*,
 	SDL_RWclose(io);
 }
 
-bool Content::isFolder(String path)
+bool Content::checkFolder(String path)
 {
 	struct stat buf;
 	if (::stat(path.toString().c_str(), &buf) == 0)
@@ -592,19 +1087,19 @@ bool Content::isFolder(String path)
 	}
 	return false;
 }
-#endif // BX_PLATFORM_WINDOWS || BX_PLATFORM_OSX || BX_PLATFORM_IOS
+#endif // BX_PLATFORM_WINDOWS || BX_PLATFORM_OSX || BX_PLATFORM_IOS || BX_PLATFORM_LINUX
 
-#if BX_PLATFORM_WINDOWS || BX_PLATFORM_ANDROID
+#if BX_PLATFORM_WINDOWS || BX_PLATFORM_ANDROID || BX_PLATFORM_LINUX
 string Content::getFullPathForDirectoryAndFilename(String directory, String filename)
 {
 	string fullPath = (Content::isAbsolutePath(directory) ? "" : _currentPath);
 	fullPath.append(directory + filename);
-	if (!Content::isFileExist(fullPath))
+	if (!Content::checkFileExist(fullPath))
 	{
 		fullPath.clear();
 	}
 	return fullPath;
 }
-#endif // BX_PLATFORM_WINDOWS || BX_PLATFORM_ANDROID
+#endif // BX_PLATFORM_WINDOWS || BX_PLATFORM_ANDROID || BX_PLATFORM_LINUX
 
 NS_DOROTHY_END
@@ -10,17 +10,66 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
+/** @brief Read only view of the data of a file. Files on disk are mapped
+ into memory where mapping is supported, otherwise the file data is loaded.
+ Used with Ref<FileView>, can be made in a worker thread. */
+class FileView : public ThreadSafeObject
+{
+public:
+	/** @brief Take a buffer allocated by new[]. */
+	FileView(Uint8* buffer, Sint64 size);
+	/** @brief View a part of another file view, which is kept alive by this view. */
+	FileView(FileView* owner, Sint64 offset, Sint64 size);
+	virtual ~FileView();
+	/** @brief Map a file, return nullptr when failed or not supported. */
+	static FileView* map(const string& fullPath);
+	inline const char* rawData() const
+	{
+		return _data ? r_cast<const char*>(_data) : "";
+	}
+	inline size_t size() const
+	{
+		return s_cast<size_t>(_size);
+	}
+	inline bool empty() const
+	{
+		return _size == 0;
+	}
+	inline Slice toSlice() const
+	{
+		return Slice(FileView::rawData(), FileView::size());
+	}
+private:
+	FileView();
+	Uint8* _data;
+	Sint64 _size;
+	bool _mapped;
+	Ref<FileView> _owner;
+};
+
+class Pack;
+
 class Content : public Object
 {
 public:
 	PROPERTY_READONLY_REF(string, CurrentPath);
 	PROPERTY_READONLY_REF(string, WritablePath);
+	/** @brief Changed whenever resolved paths may change, for caches of resolved files. */
+	PROPERTY_READONLY(Uint32, PathVersion);
 	virtual ~Content();
+	/** @brief Answered from the path cache after the first query, files in packs included. */
 	bool isFileExist(String filePath);
 	bool isFolder(String path);
     bool isAbsolutePath(String strPath);
 	string getFullPath(String filename);
+	/** @brief Check whether the file is found in the current path or the search paths.
+	 Answered from the path cache after the first query, misses included. */
+	bool hasFile(String filename);
+	/** @brief Forget the cached paths, call it after files are changed without Content. */
+	void clearPathCache();
 	OwnArray<Uint8> loadFile(String filename, Sint64& size);
+	/** @brief Get the file data without copying it when the file can be mapped. */
+	Ref<FileView> mapFile(String filename);
 	void copyFile(String src, String dst);
 	bool removeFile(String filename);
 	void saveToFile(String filename, String content);
@@ -30,16 +79,32 @@ public:
 	void addSearchPath(String path);
 	void removeSearchPath(String path);
 	void setSearchPaths(const vector<string>& searchPaths);
+	/** @brief Add a pack file made by Tools/Pack as a search path,
+	 files in the pack are also found by the pack path joined with the entry name. */
+	bool mountPack(String packFile);
+	void unmountPack(String packFile);
 	void loadFileAsync(String filename, const function<void(OwnArray<Uint8>, Sint64)>& callback);
+	void mapFileAsync(String filename, const function<void(Ref<FileView>)>& callback);
 	void copyFileAsync(String src, String dst, const function<void()>& callback);
 	void saveToFileAsync(String filename, String content, const function<void()>& callback);
 	void saveToFileAsync(String filename, OwnArray<Uint8> content, Sint64 size, const function<void()>& callback);
 protected:
 	Content();
 	string getFullPathForDirectoryAndFilename(String directory, String filename);
+	string resolvePath(const string& targetFile);
+	string findPath(const string& targetFile, const vector<std::pair<string, Ref<Pack>>>& searchPaths);
+	/** @brief Forget the cached paths affected by a change of the file or folder. */
+	void invalidatePath(const string& path);
+	/** @brief Check the file system only, without the path cache and packs. */
+	bool checkFileExist(String filePath);
+	bool checkFolder(String path);
 	void copyFileUnsafe(String srcFile, String dstFile);
 	Uint8* loadFileUnsafe(String filename, Sint64& size);
+	Ref<FileView> mapFileUnsafe(String filename);
+	/** @brief Get the mounted pack containing the full path and the entry name in the pack. */
+	Ref<Pack> getPack(const string& fullPath, string& entryName);
 	void loadFileByChunks(String filename, const function<void(Uint8*,int)>& handler);
+	void loadPackEntryByChunks(Pack* pack, String entryName, const function<void(Uint8*,int)>& handler);
 	void loadFileAsyncUnsafe(String filename, const function<void (Uint8*, Sint64)>& callback);
 	void saveToFileUnsafe(String filename, String content);
 	void saveToFileUnsafe(String filename, Uint8* content, Sint64 size);
@@ -47,7 +112,17 @@ private:
 	string _currentPath;
 	string _writablePath;
 	vector<string> _searchPaths;
+	// resolved full paths of files, an empty string for a file not found
 	unordered_map<string, string> _fullPathCache;
+	unordered_map<string, bool> _folderCache;
+	std::atomic<Uint32> _pathVersion;
+	// changed with any change of paths, checked before caching a result searched without the lock
+	Uint32 _pathChanges;
+	// count of searches running without the lock
+	Uint32 _searching;
+	// mounted packs by their search paths
+	unordered_map<string, Ref<Pack>> _packs;
+	bx::Mutex _pathMutex;
 	LUA_TYPE_OVERRIDE(Content)
 };
 
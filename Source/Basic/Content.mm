@@ -12,7 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-bool Content::isFileExist(String filePath)
+bool Content::checkFileExist(String filePath)
 {
 	if (filePath[0] != '/')
 	{
@@ -53,45 +53,76 @@ void Director::mainLoop()
 			, stats->height
 			, stats->textWidth
 			, stats->textHeight);
+	bgfx::dbgTextPrintf(0, 2, 0x0f, "Objects %d, Autoreleased %d/%d per Frame"
+			, Object::getObjectCount()
+			, SharedPoolManager.getAutoreleaseCount()
+			, SharedPoolManager.getMaxAutoreleaseCount());
 	bgfx::dbgTextPrintf(0, 3, 0x0f, "Compute %d, Draw %d, CPU Time %.3f/%.3f, GPU Time %.3f"
 			, stats->numCompute
 			, stats->numDraw
 			, SharedApplication.getUpdateTime()
 			, (stats->cpuTimeEnd - stats->cpuTimeBegin) / double(stats->cpuTimerFreq)
 			, (stats->gpuTimeEnd - stats->gpuTimeBegin) / double(stats->gpuTimerFreq));
+	bgfx::dbgTextPrintf(0, 4, 0x0f, "Target FPS %d, Idle Time %.3f, Pacing Error %.3f/%.3f"
+			, SharedApplication.getTargetFPS()
+			, SharedApplication.getIdleTime()
+			, SharedApplication.getPacingError()
+			, SharedApplication.getAveragePacingError());
+	bgfx::dbgTextPrintf(0, 5, 0x0f, "Memory Pools %d, Capacity %d KB"
+			, MemoryPoolBase::getCount()
+			, MemoryPoolBase::getTotalCapacity() / 1024);
+	for (int i = 0; i < MemoryPoolBase::getCount(); i++)
+	{
+		MemoryPoolBase* pool = MemoryPoolBase::getPool(i);
+		bgfx::dbgTextPrintf(2, 6 + i, 0x0f, "%s: Items %d, Free %d, Chunks %d, High Water %d, Alloc %.0f/s"
+				, pool->getName().c_str()
+				, pool->getItemCount()
+				, pool->getFreeCount()
+				, pool->getChunkCount()
+				, pool->getHighWater()
+				, pool->getAllocRate());
+	}
 
 	_systemScheduler->update(SharedApplication.getDeltaTime());
 	_scheduler->update(SharedApplication.getDeltaTime());
 }
 
+// names of application events interned once
+static const Uint32 AppQuit = Atom::intern("AppQuit");
+static const Uint32 AppLowMemory = Atom::intern("AppLowMemory");
+static const Uint32 AppWillEnterBackground = Atom::intern("AppWillEnterBackground");
+static const Uint32 AppDidEnterBackground = Atom::intern("AppDidEnterBackground");
+static const Uint32 AppWillEnterForeground = Atom::intern("AppWillEnterForeground");
+static const Uint32 AppDidEnterForeground = Atom::intern("AppDidEnterForeground");
+
 void Director::handleSDLEvent(const SDL_Event& event)
 {
 	switch (event.type)
 	{
 		// User-requested quit
 		case SDL_QUIT:
-			Event::send("AppQuit"_slice);
+			Event::send(AppQuit);
 			break;
 		// The application is being terminated by the OS.
 		case SDL_APP_TERMINATING:
-			Event::send("AppQuit"_slice);
+			Event::send(AppQuit);
 			break;
 		// The application is low on memory, free memory if possible.
 		case SDL_APP_LOWMEMORY:
-			Event::send("AppLowMemory"_slice);
+			Event::send(AppLowMemory);
 			break;
 		// The application is about to enter the background.
 		case SDL_APP_WILLENTERBACKGROUND:
-			Event::send("AppWillEnterBackground"_slice);
+			Event::send(AppWillEnterBackground);
 			break;
 		case SDL_APP_DIDENTERBACKGROUND:
-			Event::send("AppDidEnterBackground"_slice);
+			Event::send(AppDidEnterBackground);
 			break;
 		case SDL_APP_WILLENTERFOREGROUND:
-			Event::send("AppWillEnterForeground"_slice);
+			Event::send(AppWillEnterForeground);
 			break;
 		case SDL_APP_DIDENTERFOREGROUND:
-			Event::send("AppDidEnterForeground"_slice);
+			Event::send(AppDidEnterForeground);
 			break;
 		case SDL_WINDOWEVENT:
 			break;
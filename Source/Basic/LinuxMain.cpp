@@ -0,0 +1,44 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+
+#if BX_PLATFORM_LINUX
+
+/* Usage: Dorothy [--headless] [--frames count] [--fps target]
+ --headless  run without a window using the Noop renderer of bgfx
+ --frames    quit after the count of frames and print frame time statistics
+ --fps       target frame rate, 0 for running as fast as possible */
+int main(int argc, char* argv[])
+{
+	using namespace Dorothy;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--headless")
+		{
+			SharedApplication.setHeadless(true);
+		}
+		else if (arg == "--frames" && i + 1 < argc)
+		{
+			SharedApplication.setFrameLimit(std::atoi(argv[++i]));
+		}
+		else if (arg == "--fps" && i + 1 < argc)
+		{
+			SharedApplication.setTargetFPS(std::atoi(argv[++i]));
+		}
+		else
+		{
+			Print("unknown argument \"%s\"\n", arg);
+			return 1;
+		}
+	}
+	return SharedApplication.run();
+}
+
+#endif // BX_PLATFORM_LINUX
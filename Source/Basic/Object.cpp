@@ -13,53 +13,62 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-Weak::Weak(Object* target):
-target(target),
-_refCount(1)
-{ }
-
-void Weak::release()
-{
-	--_refCount;
-	if (_refCount == 0)
-	{
-		delete this;
-	}
-}
-
-void Weak::retain()
-{
-	++_refCount;
-}
+// handle packs the slot generation above the 32 bits id,
+// only 20 bits of generation are kept for handles to be exact in Lua numbers
+static const int GenerationBits = 20;
+static const Uint32 GenerationMask = (1 << GenerationBits) - 1;
+// index of free slots
+static const Uint32 InvalidIndex = 0xffffffff;
 
-Uint32 Object::_maxIdCount;
 Uint32 Object::_maxLuaRefCount;
 Uint32 Object::_luaRefCount;
 
-stack<Uint32> Object::_availableIds;
+// slot 0 is reserved, so that id 0 and handle 0 are invalid
+vector<Object::Slot> Object::_slots(1);
+vector<Uint32> Object::_freeSlots;
+vector<Object*> Object::_objects;
 stack<Uint32> Object::_availableLuaRefs;
+#if DORA_DEBUG
+bool Object::_threadCheck = true;
+#endif
 
 Object::Object():
 _managed(false),
+_managedIndex(0),
+#if DORA_DEBUG
+_ownerThread(SDL_ThreadID()),
+#endif
 _refCount(1),
-_luaRef(0),
-_weak(nullptr)
+_luaRef(0)
 {
-	if (_availableIds.empty())
+	if (_freeSlots.empty())
 	{
-		_id = ++_maxIdCount;
+		_id = s_cast<Uint32>(_slots.size());
+		_slots.push_back({1, 0});
 	}
 	else
 	{
-		_id = _availableIds.top();
-		_availableIds.pop();
+		_id = _freeSlots.back();
+		_freeSlots.pop_back();
 	}
+	_slots[_id].index = s_cast<Uint32>(_objects.size());
+	_objects.push_back(this);
 }
 
 Object::~Object()
 {
 	AssertIf(_managed, "object is still managed when destroyed.");
-	_availableIds.push(_id);
+	// move the last object into the hole to keep the array packed
+	Slot& slot = _slots[_id];
+	Object* last = _objects.back();
+	_objects[slot.index] = last;
+	_slots[last->_id].index = slot.index;
+	_objects.pop_back();
+	// also expire weak references made while destroying
+	slot.generation++;
+	// a freed slot points at no object, even for a stale handle of a wrapped generation
+	slot.index = InvalidIndex;
+	_freeSlots.push_back(_id);
 	if (_luaRef != 0)
 	{
 		_availableLuaRefs.push(_luaRef);
@@ -75,14 +84,14 @@ bool Object::init()
 void Object::release()
 {
 	AssertUnless(_refCount > 0, "reference count should greater than 0.");
+#if DORA_DEBUG
+	AssertUnless(!_threadCheck || _ownerThread == SDL_ThreadID(), "object is released in another thread, use ThreadSafeObject instead.");
+#endif
     --_refCount;
     if (_refCount == 0)
     {
-		if (_weak)
-		{
-			_weak->target = nullptr;
-			_weak->release();
-		}
+		// expire weak references before the derived destructors run
+		_slots[_id].generation++;
         delete this;
     }
 }
@@ -90,9 +99,19 @@ void Object::release()
 void Object::retain()
 {
 	AssertUnless(_refCount > 0, "reference count should greater than 0.");
+#if DORA_DEBUG
+	AssertUnless(!_threadCheck || _ownerThread == SDL_ThreadID(), "object is retained in another thread, use ThreadSafeObject instead.");
+#endif
     ++_refCount;
 }
 
+void Object::disableThreadCheck()
+{
+#if DORA_DEBUG
+	_threadCheck = false;
+#endif
+}
+
 Object* Object::autorelease()
 {
 	AssertIf(_managed, "object is already managed.");
@@ -121,14 +140,35 @@ Uint32 Object::getId() const
 	return _id;
 }
 
+Uint64 Object::getHandle() const
+{
+	return (s_cast<Uint64>(_slots[_id].generation & GenerationMask) << 32) | _id;
+}
+
+Object* Object::get(Uint64 handle)
+{
+	Uint32 id = s_cast<Uint32>(handle);
+	Uint32 generation = s_cast<Uint32>(handle >> 32);
+	if (id == 0 || id >= _slots.size() || _slots[id].index == InvalidIndex || (_slots[id].generation & GenerationMask) != generation)
+	{
+		return nullptr;
+	}
+	return _objects[_slots[id].index];
+}
+
+const vector<Object*>& Object::getObjects()
+{
+	return _objects;
+}
+
 Uint32 Object::getObjectCount()
 {
-	return _maxIdCount - (Uint32)_availableIds.size();
+	return s_cast<Uint32>(_objects.size());
 }
 
 Uint32 Object::getMaxObjectCount()
 {
-	return _maxIdCount;
+	return s_cast<Uint32>(_slots.size()) - 1;
 }
 
 Uint32 Object::getLuaRefCount()
@@ -151,16 +191,6 @@ Uint32 Object::getMaxLuaCallbackCount()
 	return tolua_get_max_callback_ref_count();
 }
 
-Weak* Object::getWeakRef()
-{
-	if (!_weak)
-	{
-		_weak = new Weak(this);
-		return _weak;
-	}
-	return _weak;
-}
-
 void Object::addLuaRef()
 {
 	++_luaRefCount;
@@ -193,4 +223,32 @@ bool Object::isLuaReferenced() const
 	return _luaRef != 0;
 }
 
+ThreadSafeObject::ThreadSafeObject():
+_refCount(0)
+{ }
+
+ThreadSafeObject::~ThreadSafeObject()
+{ }
+
+Uint32 ThreadSafeObject::getRefCount() const
+{
+	return _refCount.load(std::memory_order_relaxed);
+}
+
+void ThreadSafeObject::retain()
+{
+	// a new reference is always made from an existing one
+	_refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadSafeObject::release()
+{
+	AssertUnless(_refCount > 0, "reference count should greater than 0.");
+	// make the writes from other threads visible before deleting
+	if (_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		delete this;
+	}
+}
+
 NS_DOROTHY_END
@@ -10,22 +10,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-class Object;
-class Weak
-{
-public:
-	Weak(Object* target);
-	void release();
-	void retain();
-	Object* target;
-private:
-	int _refCount;
-};
-
+/** @brief Objects are kept in a generational handle table.
+ The id is the index of the object slot, unique among living objects.
+ The handle adds the slot generation to the id, so that a handle of a
+ destroyed object is detected as stale even when the id is reused.
+ Handles keep the low 20 bits of the generation to fit in a Lua number,
+ weak references check the whole generation. */
 class Object
 {
 public:
 	PROPERTY_READONLY(Uint32, Id);
+	PROPERTY_READONLY(Uint64, Handle);
 	PROPERTY_READONLY_CALL(Uint32, LuaRef);
 	PROPERTY_READONLY_BOOL(LuaReferenced);
 	PROPERTY_READONLY_BOOL(SingleReferenced);
@@ -36,7 +31,6 @@ public:
 	PROPERTY_READONLY_CLASS(Uint32, LuaCallbackCount);
 	PROPERTY_READONLY_CLASS(Uint32, MaxLuaCallbackCount);
 	PROPERTY_READONLY(Uint32, RefCount);
-	PROPERTY_READONLY_CALL(Weak*, WeakRef);
 	virtual ~Object();
 	virtual bool init();
 	void addLuaRef();
@@ -46,16 +40,34 @@ public:
 	Object* autorelease();
 	/** @brief return true to stop updating, false to continue. */
 	virtual bool update(double deltaTime);
+	/** @brief Get the living object of the handle, nullptr for a stale handle. */
+	static Object* get(Uint64 handle);
+	/** @brief Living objects packed in an array, the order changes when objects are destroyed. */
+	static const vector<Object*>& getObjects();
+	/** @brief Stop checking the threads referencing objects,
+	 called when the remaining objects are destroyed by another thread at exit. */
+	static void disableThreadCheck();
 protected:
 	Object();
 private:
 	bool _managed;
+	Uint32 _managedIndex; // index in the managing autorelease pool
+#if DORA_DEBUG
+	SDL_threadID _ownerThread; // objects are only referenced in the creating thread
+	static bool _threadCheck;
+#endif
 	Uint32 _id; // object id, each object has unique one
 	Uint32 _refCount; // count of C++ references
 	Uint32 _luaRef; // lua reference id
-	Weak* _weak; // weak ref object
-	static Uint32 _maxIdCount;
-	static stack<Uint32> _availableIds;
+	struct Slot
+	{
+		Uint32 generation;
+		Uint32 index; // index of the object in the packed array
+	};
+	static vector<Slot> _slots;
+	static vector<Uint32> _freeSlots;
+	static vector<Object*> _objects;
+	template<class T> friend class WRef;
 	static Uint32 _maxLuaRefCount;
 	static stack<Uint32> _availableLuaRefs;
 	static Uint32 _luaRefCount;
@@ -63,4 +75,32 @@ private:
 	LUA_TYPE_BASE(Object)
 };
 
+/** @brief Base of objects shared between threads, used with Ref<T>.
+ The reference count is atomic and starts from zero. It has no id,
+ no Lua binding and can not be autoreleased, so that it can be built in
+ a worker thread and handed over to the logic thread without copying.
+ @example Use it as below.
+
+ Async::FileIO.run([]()
+ {
+ 	return Ref<Image>(new Image(decode("a.png")));
+ })
+ .then([](Ref<Image>& image)
+ {
+ 	sprite->setImage(image);
+ });
+ */
+class ThreadSafeObject
+{
+public:
+	PROPERTY_READONLY(Uint32, RefCount);
+	void retain();
+	void release();
+protected:
+	ThreadSafeObject();
+	virtual ~ThreadSafeObject();
+private:
+	std::atomic<Uint32> _refCount;
+};
+
 NS_DOROTHY_END
@@ -0,0 +1,191 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Basic/Pack.h"
+#include "Common/Lz4.h"
+#include "zlib.h"
+
+NS_DOROTHY_BEGIN
+
+Pack::Pack(const Ref<FileView>& file):
+_file(file),
+_entries(nullptr),
+_names(nullptr),
+_entryCount(0)
+{ }
+
+Pack* Pack::open(const Ref<FileView>& file)
+{
+	if (!file || file->size() < sizeof(PackHeader))
+	{
+		return nullptr;
+	}
+	const char* data = file->rawData();
+	Uint64 fileSize = file->size();
+	PackHeader header;
+	memcpy(&header, data, sizeof(PackHeader));
+	if (memcmp(header.magic, PackFormat::Magic, sizeof(header.magic)) != 0 || header.version != PackFormat::Version)
+	{
+		Log("invalid pack file.");
+		return nullptr;
+	}
+	Uint64 entriesEnd = sizeof(PackHeader) + Uint64(header.entryCount) * sizeof(PackEntry);
+	if (entriesEnd > fileSize || header.namesOffset < entriesEnd ||
+		header.namesOffset > fileSize || header.namesSize > fileSize - header.namesOffset)
+	{
+		Log("pack file is truncated.");
+		return nullptr;
+	}
+	Pack* pack = new Pack(file);
+	pack->_entries = r_cast<const PackEntry*>(data + sizeof(PackHeader));
+	pack->_names = data + header.namesOffset;
+	pack->_entryCount = header.entryCount;
+	// check entries once so that they are trusted when loading
+	for (Uint32 i = 0; i < header.entryCount; i++)
+	{
+		const PackEntry& entry = pack->_entries[i];
+		if (Uint64(entry.nameOffset) + entry.nameLength > header.namesSize ||
+			entry.offset > fileSize || entry.size > fileSize - entry.offset)
+		{
+			Log("pack file is truncated.");
+			delete pack;
+			return nullptr;
+		}
+		string name(pack->_names + entry.nameOffset, entry.nameLength);
+		for (size_t pos = name.find('/'); pos != string::npos; pos = name.find('/', pos + 1))
+		{
+			pack->_folders.insert(name.substr(0, pos));
+		}
+	}
+	return pack;
+}
+
+int Pack::getEntryCount() const
+{
+	return s_cast<int>(_entryCount);
+}
+
+const PackEntry* Pack::find(String name) const
+{
+	string normalized;
+	Slice target = name;
+	if (std::find(name.begin(), name.end(), '\\') != name.end())
+	{
+		normalized = name;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+		target = normalized;
+	}
+	Uint64 hash = PackHash(target.rawData(), target.size());
+	const PackEntry* end = _entries + _entryCount;
+	const PackEntry* it = std::lower_bound(_entries, end, hash, [](const PackEntry& entry, Uint64 hash)
+	{
+		return entry.hash < hash;
+	});
+	for (; it != end && it->hash == hash; ++it)
+	{
+		if (it->nameLength == target.size() && memcmp(_names + it->nameOffset, target.rawData(), target.size()) == 0)
+		{
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+bool Pack::hasEntry(String name) const
+{
+	return Pack::find(name) != nullptr;
+}
+
+bool Pack::isFolder(String name) const
+{
+	string folder = name;
+	std::replace(folder.begin(), folder.end(), '\\', '/');
+	while (!folder.empty() && folder.back() == '/')
+	{
+		folder.pop_back();
+	}
+	return folder.empty() || _folders.find(folder) != _folders.end();
+}
+
+Uint8* Pack::decompress(const PackEntry* entry) const
+{
+	Uint8* data = new Uint8[entry->originalSize];
+	const Uint8* source = r_cast<const Uint8*>(_file->rawData()) + entry->offset;
+	bool result;
+	if (entry->compression == PackFormat::Lz4)
+	{
+		result = Lz4::decompress(source, entry->size, data, entry->originalSize);
+	}
+	else
+	{
+		uLongf size = entry->originalSize;
+		result = uncompress(data, &size, source, entry->size) == Z_OK && size == entry->originalSize;
+	}
+	if (!result)
+	{
+		Log("fail to decompress pack entry: %s", string(_names + entry->nameOffset, entry->nameLength));
+		delete [] data;
+		return nullptr;
+	}
+	return data;
+}
+
+Ref<FileView> Pack::load(String name) const
+{
+	const PackEntry* entry = Pack::find(name);
+	if (!entry)
+	{
+		return Ref<FileView>();
+	}
+	switch (entry->compression)
+	{
+		case PackFormat::Stored:
+			return Ref<FileView>(new FileView(_file, entry->offset, entry->size));
+		case PackFormat::Deflate:
+		case PackFormat::Lz4:
+		{
+			Uint8* data = Pack::decompress(entry);
+			return data ? Ref<FileView>(new FileView(data, entry->originalSize)) : Ref<FileView>();
+		}
+		default:
+			Log("unsupported compression of pack entry: %s", name);
+			return Ref<FileView>();
+	}
+}
+
+Uint8* Pack::loadData(String name, Sint64& size) const
+{
+	const PackEntry* entry = Pack::find(name);
+	if (!entry)
+	{
+		return nullptr;
+	}
+	switch (entry->compression)
+	{
+		case PackFormat::Stored:
+		{
+			Uint8* data = new Uint8[entry->size];
+			memcpy(data, _file->rawData() + entry->offset, entry->size);
+			size = entry->size;
+			return data;
+		}
+		case PackFormat::Deflate:
+		case PackFormat::Lz4:
+		{
+			Uint8* data = Pack::decompress(entry);
+			if (data) size = entry->originalSize;
+			return data;
+		}
+		default:
+			Log("unsupported compression of pack entry: %s", name);
+			return nullptr;
+	}
+}
+
+NS_DOROTHY_END
@@ -0,0 +1,43 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include "Basic/PackFormat.h"
+
+NS_DOROTHY_BEGIN
+
+/** @brief Read only archive of files made by Tools/Pack.
+ The pack data is kept mapped, entries are found by binary searching
+ the sorted name hashes and stored entries are served without copying.
+ Used with Ref<Pack>, can be read in worker threads. */
+class Pack : public ThreadSafeObject
+{
+public:
+	/** @brief Open a pack from its file data, return nullptr when the data is not a valid pack. */
+	static Pack* open(const Ref<FileView>& file);
+	PROPERTY_READONLY(int, EntryCount);
+	bool hasEntry(String name) const;
+	bool isFolder(String name) const;
+	/** @brief Get an entry by its name relative to the pack,
+	 stored entries are views of the pack data. */
+	Ref<FileView> load(String name) const;
+	/** @brief Get a copy of the entry data allocated by new[]. */
+	Uint8* loadData(String name, Sint64& size) const;
+private:
+	Pack(const Ref<FileView>& file);
+	const PackEntry* find(String name) const;
+	Uint8* decompress(const PackEntry* entry) const;
+	Ref<FileView> _file;
+	const PackEntry* _entries;
+	const char* _names;
+	Uint32 _entryCount;
+	unordered_set<string> _folders;
+};
+
+NS_DOROTHY_END
@@ -0,0 +1,70 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+NS_DOROTHY_BEGIN
+
+/** @brief Layout of a Dorothy pack file, shared by the engine and the pack tool.
+ Numbers are little endian. A pack is made of
+ [PackHeader][PackEntry * entryCount][names][data]
+ with entries sorted by name hash then name and the data of
+ every entry starting at an offset aligned to PackAlignment. */
+namespace PackFormat
+{
+	static const char Magic[4] = {'D', 'P', 'A', 'K'};
+	static const uint32_t Version = 1;
+	static const uint64_t Alignment = 16;
+	enum Compression
+	{
+		Stored = 0,
+		Deflate = 1,
+		Lz4 = 2 // LZ4 block, decoded several times faster than deflate
+	};
+}
+
+struct PackHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t namesSize;
+	uint64_t namesOffset;
+	uint64_t reserved;
+};
+
+struct PackEntry
+{
+	uint64_t hash;
+	uint64_t offset;
+	uint32_t size; // bytes stored in pack
+	uint32_t originalSize;
+	uint32_t nameOffset;
+	uint16_t nameLength;
+	uint8_t compression;
+	uint8_t reserved;
+};
+
+static_assert(sizeof(PackHeader) == 32 && sizeof(PackEntry) == 32, "pack layout should not be padded.");
+
+/** @brief FNV-1a hash of entry names, names use '/' as separator. */
+inline uint64_t PackHash(const char* name, size_t length)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= static_cast<uint8_t>(name[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+NS_DOROTHY_END
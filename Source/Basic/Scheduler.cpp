@@ -11,85 +11,212 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-// pretend to be a compactible object for AcfDelegate
-class FuncWrapper
+// handle packs the slot index in low 32 bits and the slot generation in high 32 bits,
+// so that a stale handle matches a reused slot only after 2^32 reuses
+static const int SlotBits = 32;
+
+Scheduler::Scheduler():
+_timeScale(1.0f),
+_updating(false),
+_removedCount(0)
+{ }
+
+void Scheduler::setTimeScale(float value)
+{
+	_timeScale = max(0.0f, value);
+}
+
+float Scheduler::getTimeScale() const
+{
+	return _timeScale;
+}
+
+int Scheduler::getCount() const
 {
-public:
-	FuncWrapper(const function<bool (double)>& func):_func(func) { }
-	const FuncWrapper& operator*() const { return *this; }
-	bool operator==(const FuncWrapper& wrapper) const
+	return s_cast<int>(_entries.size() + _pendingEntries.size()) - _removedCount;
+}
+
+Uint64 Scheduler::schedule(Object* object)
+{
+	auto it = _objectHandles.find(object);
+	if (it != _objectHandles.end())
 	{
-		return _func.target<bool(*)(double)>() == wrapper._func.target<bool(*)(double)>();
+		return it->second;
 	}
-	void call(double deltaTime, Scheduler* scheduler) const
+	Uint64 handle = Scheduler::add(object, nullptr);
+	_objectHandles[object] = handle;
+	return handle;
+}
+
+Uint64 Scheduler::schedule(const function<bool (double)>& handler)
+{
+	return Scheduler::add(nullptr, handler);
+}
+
+void Scheduler::unschedule(Object* object)
+{
+	auto it = _objectHandles.find(object);
+	if (it != _objectHandles.end())
 	{
-		if (_func(deltaTime))
-		{
-			scheduler->unschedule(_func);
-		}
+		Scheduler::unschedule(it->second);
 	}
-private:
-	function<bool (double)> _func;
-};
+}
 
-// tweak to deal with return value
-class ObjectWrapper
+void Scheduler::unschedule(const function<bool (double)>& handler)
 {
-public:
-	ObjectWrapper(Object* object):_object(object) { }
-	const ObjectWrapper& operator*() const { return *this; }
-	bool operator==(const ObjectWrapper& wrapper) const
+	auto target = handler.target<bool(*)(double)>();
+	if (!target)
 	{
-		return _object == wrapper._object;
+		return;
 	}
-	void call(double deltaTime, Scheduler* scheduler) const
+	auto match = [&](vector<Entry>& entries)
 	{
-		if (_object->update(deltaTime))
+		for (auto it = entries.rbegin(); it != entries.rend(); ++it)
 		{
-			scheduler->unschedule(_object);
+			if (!it->alive || it->object) continue;
+			auto entryTarget = it->handler.target<bool(*)(double)>();
+			if (entryTarget && *entryTarget == *target)
+			{
+				Scheduler::remove(*it);
+				return true;
+			}
 		}
+		return false;
+	};
+	if (!match(_pendingEntries))
+	{
+		match(_entries);
 	}
-private:
-	Ref<Object> _object;
-};
+}
 
-Scheduler::Scheduler():
-_timeScale(1.0f)
-{ }
+void Scheduler::unschedule(Uint64 handle)
+{
+	Entry* entry = Scheduler::getEntry(handle);
+	if (entry)
+	{
+		Scheduler::remove(*entry);
+	}
+}
 
-void Scheduler::setTimeScale(float value)
+Uint64 Scheduler::add(Object* object, const function<bool (double)>& handler)
 {
-	_timeScale = max(0.0f, value);
+	Uint32 slot;
+	if (_freeSlots.empty())
+	{
+		slot = s_cast<Uint32>(_slots.size());
+		_slots.push_back({1, 0});
+	}
+	else
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	// updates scheduled while updating start from next frame
+	vector<Entry>& entries = _updating ? _pendingEntries : _entries;
+	_slots[slot].index = s_cast<Uint32>(_entries.size() + _pendingEntries.size());
+	entries.push_back({Ref<Object>(object), handler, slot, true});
+	return (s_cast<Uint64>(_slots[slot].generation) << SlotBits) | slot;
 }
 
-float Scheduler::getTimeScale() const
+void Scheduler::remove(Entry& entry)
 {
-	return _timeScale;
+	// keep the removed entry alive since it may be running now
+	entry.alive = false;
+	_removedCount++;
+	if (entry.object)
+	{
+		_objectHandles.erase(entry.object);
+	}
+	Slot& slot = _slots[entry.slot];
+	if (++slot.generation == 0) slot.generation = 1;
+	_freeSlots.push_back(entry.slot);
 }
 
-void Scheduler::schedule(Object* object)
+Scheduler::Entry* Scheduler::getEntry(Uint64 handle)
 {
-	_updateHandler += std::make_pair(ObjectWrapper(object), &ObjectWrapper::call);
+	Uint32 slot = s_cast<Uint32>(handle);
+	if (slot >= _slots.size() || _slots[slot].generation != handle >> SlotBits)
+	{
+		return nullptr;
+	}
+	Uint32 index = _slots[slot].index;
+	Entry& entry = index < _entries.size() ? _entries[index] : _pendingEntries[index - _entries.size()];
+	return entry.alive ? &entry : nullptr;
 }
 
-void Scheduler::schedule(const function<bool (double)>& handler)
+void Scheduler::compact()
 {
-	_updateHandler += std::make_pair(FuncWrapper(handler), &FuncWrapper::call);
+	size_t count = 0;
+	for (size_t i = 0; i < _entries.size(); i++)
+	{
+		if (_entries[i].alive)
+		{
+			if (count != i)
+			{
+				_entries[count] = std::move(_entries[i]);
+			}
+			_slots[_entries[count].slot].index = s_cast<Uint32>(count);
+			count++;
+		}
+	}
+	_entries.erase(_entries.begin() + count, _entries.end());
+	for (Entry& entry : _pendingEntries)
+	{
+		if (entry.alive)
+		{
+			_slots[entry.slot].index = s_cast<Uint32>(_entries.size());
+			_entries.push_back(std::move(entry));
+		}
+	}
+	_pendingEntries.clear();
+	_removedCount = 0;
 }
 
-void Scheduler::unschedule(Object* object)
+Uint64 Scheduler::scheduleOnce(double delay, const function<void()>& handler)
 {
-	_updateHandler -= std::make_pair(ObjectWrapper(object), &ObjectWrapper::call);
+	return _timerWheel.add(delay, 0, [handler]()
+	{
+		handler();
+		return true;
+	});
 }
 
-void Scheduler::unschedule(const function<bool (double)>& handler)
+Uint64 Scheduler::scheduleRepeat(double interval, const function<bool()>& handler)
 {
-	_updateHandler -= std::make_pair(FuncWrapper(handler), &FuncWrapper::call);
+	return _timerWheel.add(interval, interval, handler);
+}
+
+void Scheduler::unscheduleTimer(Uint64 timer)
+{
+	_timerWheel.cancel(timer);
+}
+
+int Scheduler::getTimerCount() const
+{
+	return _timerWheel.getCount();
 }
 
 bool Scheduler::update(double deltaTime)
 {
-	_updateHandler(deltaTime * _timeScale, this);
+	double scaledDelta = deltaTime * _timeScale;
+	_timerWheel.update(scaledDelta);
+	_updating = true;
+	// entries won't move during updating, new ones are pending
+	for (size_t i = 0; i < _entries.size(); i++)
+	{
+		Entry& entry = _entries[i];
+		if (!entry.alive) continue;
+		bool done = entry.object ? entry.object->update(scaledDelta) : entry.handler(scaledDelta);
+		if (done && entry.alive)
+		{
+			Scheduler::remove(entry);
+		}
+	}
+	_updating = false;
+	if (_removedCount > 0 || !_pendingEntries.empty())
+	{
+		Scheduler::compact();
+	}
 	return false;
 }
 
@@ -10,21 +10,69 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
+/** @brief Runs updates of objects and functions every frame.
+ Updates are kept in a slot map, iterated in scheduled order and
+ removed in constant time with the handles returned by schedule().
+ Updates are safe to be scheduled or unscheduled while updating. */
 class Scheduler : public Object
 {
-	typedef Delegate<void (double deltaTime, Scheduler* scheduler)> UpdateHandler;
 public:
 	PROPERTY(float, _timeScale, TimeScale);
-	void schedule(Object* object);
-	void schedule(const function<bool (double)>& handler);
+	/** @brief Count of scheduled updates. */
+	PROPERTY_READONLY(int, Count);
+	/** @brief Update the object every frame until its update returns true,
+	 an object is only scheduled once by a scheduler.
+	 @return handle to unschedule the update. */
+	Uint64 schedule(Object* object);
+	/** @brief Call the handler every frame until it returns true.
+	 @return handle to unschedule the update. */
+	Uint64 schedule(const function<bool (double)>& handler);
 	void unschedule(Object* object);
+	/** @brief Only handlers wrapping the same function pointer are found,
+	 use the handle to unschedule a lambda. */
 	void unschedule(const function<bool (double)>& handler);
+	/** @brief Unschedule by handle, stale handles are ignored. */
+	void unschedule(Uint64 handle);
+	/** @brief Call the handler once after the delay seconds scaled by time scale.
+	 @return handle of the timer. */
+	Uint64 scheduleOnce(double delay, const function<void()>& handler);
+	/** @brief Call the handler every interval seconds scaled by time scale
+	 until it returns true.
+	 @return handle of the timer. */
+	Uint64 scheduleRepeat(double interval, const function<bool()>& handler);
+	void unscheduleTimer(Uint64 timer);
+	/** @brief Count of pending timers. */
+	PROPERTY_READONLY(int, TimerCount);
 	virtual bool update(double deltaTime) override;
 	CREATE_FUNC(Scheduler)
 protected:	
 	Scheduler();
 private:
-	UpdateHandler _updateHandler;
+	struct Entry
+	{
+		Ref<Object> object;
+		function<bool (double)> handler;
+		Uint32 slot;
+		bool alive;
+	};
+	struct Slot
+	{
+		Uint32 generation;
+		Uint32 index;
+	};
+	Uint64 add(Object* object, const function<bool (double)>& handler);
+	void remove(Entry& entry);
+	Entry* getEntry(Uint64 handle);
+	void compact();
+	bool _updating;
+	int _removedCount;
+	vector<Entry> _entries;
+	// entries scheduled while updating
+	vector<Entry> _pendingEntries;
+	vector<Slot> _slots;
+	vector<Uint32> _freeSlots;
+	unordered_map<Object*, Uint64> _objectHandles;
+	TimerWheel _timerWheel;
 	LUA_TYPE_OVERRIDE(Scheduler)
 };
 
@@ -0,0 +1,233 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Basic/TimerWheel.h"
+
+NS_DOROTHY_BEGIN
+
+// the first level has 256 buckets of one tick,
+// the other three levels have 64 buckets each of a full lower level
+static const int RootBits = 8;
+static const int LevelBits = 6;
+static const int LevelCount = 3;
+static const Uint32 RootSize = 1 << RootBits;
+static const Uint32 LevelSize = 1 << LevelBits;
+static const Uint64 MaxTicks = (Uint64(1) << (RootBits + LevelBits * LevelCount)) - 1;
+static const Uint32 Nil = 0xffffffff;
+
+// handle packs the timer index in low 32 bits and the timer generation in high 32 bits,
+// so that a stale handle matches a reused timer only after 2^32 reuses
+static const int IndexBits = 32;
+
+TimerWheel::TimerWheel(double tickTime):
+_tickTime(tickTime),
+_time(0),
+_currentTick(0),
+_count(0),
+_firingIndex(Nil),
+_buckets(RootSize + LevelSize * LevelCount, Nil)
+{ }
+
+double TimerWheel::getTickTime() const
+{
+	return _tickTime;
+}
+
+int TimerWheel::getCount() const
+{
+	return _count;
+}
+
+Uint64 TimerWheel::add(double delay, double interval, const function<bool()>& handler)
+{
+	Uint32 index;
+	if (_freeTimers.empty())
+	{
+		index = s_cast<Uint32>(_timers.size());
+		_timers.push_back(Timer());
+		_timers.back().generation = 1;
+	}
+	else
+	{
+		index = _freeTimers.back();
+		_freeTimers.pop_back();
+	}
+	Timer& timer = _timers[index];
+	timer.handler = handler;
+	Uint64 delayTicks = max(Uint64(1), Uint64(delay / _tickTime + 0.5));
+	timer.expireTick = _currentTick + min(delayTicks, MaxTicks);
+	timer.intervalTicks = interval > 0 ? s_cast<Uint32>(min(max(Uint64(1), Uint64(interval / _tickTime + 0.5)), MaxTicks)) : 0;
+	timer.canceled = false;
+	timer.bucket = Nil;
+	TimerWheel::place(index);
+	_count++;
+	return (s_cast<Uint64>(timer.generation) << IndexBits) | index;
+}
+
+void TimerWheel::cancel(Uint64 handle)
+{
+	Uint32 index = s_cast<Uint32>(handle);
+	if (index >= _timers.size())
+	{
+		return;
+	}
+	Timer& timer = _timers[index];
+	if (timer.generation != handle >> IndexBits || timer.canceled)
+	{
+		return;
+	}
+	if (index == _firingIndex)
+	{
+		// released after the running callback returns
+		timer.canceled = true;
+	}
+	else
+	{
+		TimerWheel::unlink(index);
+		TimerWheel::free(index);
+	}
+}
+
+void TimerWheel::update(double deltaTime)
+{
+	_time += deltaTime;
+	Uint64 targetTick = s_cast<Uint64>(_time / _tickTime);
+	if (_count == 0)
+	{
+		_currentTick = max(_currentTick, targetTick);
+		return;
+	}
+	while (_currentTick < targetTick)
+	{
+		_currentTick++;
+		if ((_currentTick & (RootSize - 1)) == 0)
+		{
+			TimerWheel::cascade(0);
+		}
+		TimerWheel::fire(s_cast<Uint32>(_currentTick & (RootSize - 1)));
+		if (_count == 0)
+		{
+			_currentTick = targetTick;
+		}
+	}
+}
+
+void TimerWheel::place(Uint32 index)
+{
+	Timer& timer = _timers[index];
+	Uint64 ticks = timer.expireTick - _currentTick;
+	if (ticks < RootSize)
+	{
+		TimerWheel::link(index, s_cast<Uint32>(timer.expireTick & (RootSize - 1)));
+		return;
+	}
+	for (int level = 0; level < LevelCount; level++)
+	{
+		int shift = RootBits + LevelBits * level;
+		if (ticks < (Uint64(1) << (shift + LevelBits)) || level == LevelCount - 1)
+		{
+			Uint32 slot = s_cast<Uint32>((timer.expireTick >> shift) & (LevelSize - 1));
+			TimerWheel::link(index, RootSize + LevelSize * level + slot);
+			return;
+		}
+	}
+}
+
+void TimerWheel::link(Uint32 index, Uint32 bucket)
+{
+	Timer& timer = _timers[index];
+	timer.bucket = bucket;
+	timer.prev = Nil;
+	timer.next = _buckets[bucket];
+	if (timer.next != Nil)
+	{
+		_timers[timer.next].prev = index;
+	}
+	_buckets[bucket] = index;
+}
+
+void TimerWheel::unlink(Uint32 index)
+{
+	Timer& timer = _timers[index];
+	if (timer.bucket == Nil)
+	{
+		return;
+	}
+	if (timer.prev != Nil)
+	{
+		_timers[timer.prev].next = timer.next;
+	}
+	else
+	{
+		_buckets[timer.bucket] = timer.next;
+	}
+	if (timer.next != Nil)
+	{
+		_timers[timer.next].prev = timer.prev;
+	}
+	timer.bucket = Nil;
+}
+
+void TimerWheel::free(Uint32 index)
+{
+	Timer& timer = _timers[index];
+	timer.handler = nullptr;
+	if (++timer.generation == 0) timer.generation = 1;
+	_freeTimers.push_back(index);
+	_count--;
+}
+
+void TimerWheel::cascade(int level)
+{
+	int shift = RootBits + LevelBits * level;
+	Uint32 slot = s_cast<Uint32>((_currentTick >> shift) & (LevelSize - 1));
+	if (slot == 0 && level + 1 < LevelCount)
+	{
+		TimerWheel::cascade(level + 1);
+	}
+	Uint32 bucket = RootSize + LevelSize * level + slot;
+	Uint32 index = _buckets[bucket];
+	_buckets[bucket] = Nil;
+	while (index != Nil)
+	{
+		Uint32 next = _timers[index].next;
+		_timers[index].bucket = Nil;
+		TimerWheel::place(index);
+		index = next;
+	}
+}
+
+void TimerWheel::fire(Uint32 bucket)
+{
+	while (_buckets[bucket] != Nil)
+	{
+		Uint32 index = _buckets[bucket];
+		TimerWheel::unlink(index);
+		Timer& timer = _timers[index];
+		_firingIndex = index;
+		bool done = timer.handler() || timer.intervalTicks == 0;
+		_firingIndex = Nil;
+		if (done || timer.canceled)
+		{
+			timer.canceled = false;
+			TimerWheel::free(index);
+		}
+		else
+		{
+			timer.expireTick += timer.intervalTicks;
+			if (timer.expireTick <= _currentTick)
+			{
+				timer.expireTick = _currentTick + 1;
+			}
+			TimerWheel::place(index);
+		}
+	}
+}
+
+NS_DOROTHY_END
@@ -0,0 +1,65 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include <deque>
+
+NS_DOROTHY_BEGIN
+
+/** @brief Hierarchical timing wheel for delayed and repeating callbacks.
+ Timers are hashed into buckets by their expire ticks, an update only visits
+ the buckets of the ticks it advances and the buckets cascading down,
+ so pending timers cost nothing until they expire.
+ Timers are safe to be added or canceled in timer callbacks. */
+class TimerWheel
+{
+public:
+	/** @param tickTime seconds of a tick, the resolution of timers. */
+	TimerWheel(double tickTime = 0.001);
+	PROPERTY_READONLY(double, TickTime);
+	/** @brief Count of pending timers. */
+	PROPERTY_READONLY(int, Count);
+	/** @brief Call the handler after the delay seconds,
+	 then every interval seconds until it returns true when interval is positive.
+	 @return handle to cancel the timer. */
+	Uint64 add(double delay, double interval, const function<bool()>& handler);
+	/** @brief Cancel a pending timer, stale handles are ignored. */
+	void cancel(Uint64 handle);
+	/** @brief Advance the time and run expired timers. */
+	void update(double deltaTime);
+private:
+	struct Timer
+	{
+		function<bool()> handler;
+		Uint64 expireTick;
+		Uint32 intervalTicks;
+		Uint32 generation;
+		Uint32 bucket;
+		Uint32 prev;
+		Uint32 next;
+		bool canceled;
+	};
+	void place(Uint32 index);
+	void link(Uint32 index, Uint32 bucket);
+	void unlink(Uint32 index);
+	void free(Uint32 index);
+	void cascade(int level);
+	void fire(Uint32 bucket);
+	double _tickTime;
+	double _time;
+	Uint64 _currentTick;
+	int _count;
+	Uint32 _firingIndex;
+	// deque keeps timers in place when new ones are added in callbacks
+	std::deque<Timer> _timers;
+	vector<Uint32> _freeTimers;
+	vector<Uint32> _buckets;
+};
+
+NS_DOROTHY_END
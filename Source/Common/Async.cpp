@@ -14,107 +14,104 @@ NS_DOROTHY_BEGIN
 Async Async::FileIO;
 Async Async::Process;
 
+Async::Async():
+_paused(false),
+_working(false),
+_counter(new JobCounter())
+{ }
+
 Async::~Async()
 {
-	if (_thread.isRunning())
+	// running works still use this Async, the counter is done when the job system is shut down
+	Async::cancel();
+	if (!_counter->isDone())
 	{
-		Async::cancel();
-		_workerEvent.post("Stop"_slice);
-		_workerSemaphore.post();
-		_thread.shutdown();
+		SharedJobSystem.wait(_counter);
 	}
 }
 
 void Async::run(function<void*()> worker, function<void(void*)> finisher)
 {
-	if (!_thread.isRunning())
+	Async::run(std::move(worker)).then(std::move(finisher));
+}
+
+void Async::submit(Package package)
+{
+	bx::MutexScope lock(_mutex);
+	_packages.push_back(std::move(package));
+	if (!_paused && !_working)
 	{
-		_thread.init(Async::work, this);
-		SharedDirector.getSystemScheduler()->schedule([this](double deltaTime)
-		{
-			DORA_UNUSED_PARAM(deltaTime);
-			Own<QEvent> event = _finisherEvent.poll();
-			if (event)
-			{
-				Package package;
-				void* result;
-				EventQueue::retrieve(event, package, result);
-				package.second(result);
-			}
-			return false;
-		});
+		Async::start();
 	}
-	auto package = std::make_pair(worker, finisher);
-	_workerEvent.post("Work"_slice, package);
-	_workerSemaphore.post();
 }
 
-int Async::work(void* userData)
+void Async::start()
 {
-	Async* worker = r_cast<Async*>(userData);
-	while (true)
+	// only one job runs the works at a time, so they run in order
+	_working = true;
+	SharedJobSystem.run([this]()
 	{
-		for (Own<QEvent> event = worker->_workerEvent.poll();
-			event != nullptr;
-			event = worker->_workerEvent.poll())
+		Async::work();
+	}, nullptr, _counter);
+}
+
+void Async::work()
+{
+	Package package;
+	{
+		bx::MutexScope lock(_mutex);
+		if (_packages.empty())
 		{
-			switch (Switch::hash(event->getName()))
-			{
-				case "Work"_hash:
-				{
-					Package package;
-					EventQueue::retrieve(event, package);
-					void* result = package.first();
-					worker->_finisherEvent.post(Slice::Empty, package, result);
-					break;
-				}
-				case "Stop"_hash:
-				{
-					return 0;
-				}
-			}
+			_working = false;
+			return;
 		}
-		worker->_pauseSemaphore.post();
-		worker->_workerSemaphore.wait();
+		package = std::move(_packages.front());
+		_packages.pop_front();
+	}
+	package();
+	bx::MutexScope lock(_mutex);
+	if (_paused || _packages.empty())
+	{
+		_working = false;
+	}
+	else
+	{
+		// chain the next work as a new job, so that other jobs get their turns
+		Async::start();
 	}
-	return 0;
 }
 
 void Async::pause()
 {
-	if (_thread.isRunning())
 	{
-		for (Own<QEvent> event = _workerEvent.poll();
-			event != nullptr;
-			event = _workerEvent.poll())
+		bx::MutexScope lock(_mutex);
+		if (_paused)
 		{
-			Package package;
-			EventQueue::retrieve(event, package);
-			_packages.push_back(package);
+			return;
 		}
-		_workerSemaphore.post();
-		_pauseSemaphore.wait();
+		_paused = true;
 	}
+	SharedJobSystem.wait(_counter);
 }
 
 void Async::resume()
 {
-	if (_thread.isRunning() && !_packages.empty())
+	bx::MutexScope lock(_mutex);
+	if (_paused)
 	{
-		for (const auto& package : _packages)
+		_paused = false;
+		if (!_packages.empty() && !_working)
 		{
-			_workerEvent.post("Work"_slice, package);
+			Async::start();
 		}
-		_packages.clear();
-		_workerSemaphore.post();
 	}
 }
 
 void Async::cancel()
 {
-	for (Own<QEvent> event = _workerEvent.poll();
-		event != nullptr;
-		event = _workerEvent.poll());
+	// the running work is finished, works not started are dropped
+	bx::MutexScope lock(_mutex);
+	_packages.clear();
 }
 
 NS_DOROTHY_END
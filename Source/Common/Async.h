@@ -11,26 +11,53 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 NS_DOROTHY_BEGIN
 
 /** @brief get a worker runs in another thread and returns a result,
- get a finisher receives the result and runs in main thread. */
+ get a finisher receives the result and runs in main thread.
+ Works of an Async are run one by one in submitting order by the shared job system,
+ pausing an Async waits for its running work to be done and holds its new works until resumed. */
 class Async
 {
-	typedef std::pair<function<void*()>,function<void(void*)>> Package;
+	typedef Task Package;
+	template<class T, class Worker>
+	struct Work
+	{
+		Promise<T> promise;
+		Worker worker;
+		void operator()()
+		{
+			promise.setWith(worker);
+		}
+	};
 public:
+	Async();
 	~Async();
+	/** @brief Run a worker in another thread and get a future of its result,
+	 the future is never ready when the work is canceled. */
+	template<class Func>
+	Future<typename std::decay<decltype(std::declval<Func&>()())>::type> run(Func&& worker)
+	{
+		typedef typename std::decay<decltype(std::declval<Func&>()())>::type T;
+		typedef typename std::decay<Func>::type Worker;
+		Promise<T> promise;
+		Future<T> future = promise.getFuture();
+		// the worker is moved into the package without a copy
+		Async::submit(Work<T, Worker>{std::move(promise), std::forward<Func>(worker)});
+		return future;
+	}
 	void run(function<void*()> worker, function<void(void*)> finisher);
 	void pause();
 	void resume();
 	void cancel();
 	static Async FileIO;
 	static Async Process;
-	static int work(void* userData);
 private:
-	bx::Thread _thread;
-	bx::Semaphore _workerSemaphore;
-	bx::Semaphore _pauseSemaphore;
-	vector<Package> _packages;
-	EventQueue _workerEvent;
-	EventQueue _finisherEvent;
+	void submit(Package package);
+	void start();
+	void work();
+	bool _paused;
+	bool _working; // a job is running the queued works
+	Ref<JobCounter> _counter;
+	std::deque<Package> _packages;
+	bx::Mutex _mutex;
 };
 
 NS_DOROTHY_END
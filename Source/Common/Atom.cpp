@@ -0,0 +1,146 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Common/Atom.h"
+
+NS_DOROTHY_BEGIN
+
+// FNV-1a
+static size_t hashName(String name)
+{
+	size_t hash = 2166136261u;
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		hash = (hash ^ s_cast<Uint8>(name.rawData()[i])) * 16777619u;
+	}
+	return hash;
+}
+
+struct AtomEntry
+{
+	string name;
+	size_t hash;
+	Uint32 id;
+};
+
+// open addressing slots, entries are never changed once published
+struct AtomSlots
+{
+	AtomSlots(size_t capacity):
+	mask(capacity - 1),
+	entries(new std::atomic<AtomEntry*>[capacity])
+	{
+		for (size_t i = 0; i < capacity; i++)
+		{
+			entries[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+	AtomEntry* find(String name, size_t hash) const
+	{
+		for (size_t i = hash & mask;; i = (i + 1) & mask)
+		{
+			AtomEntry* entry = entries[i].load(std::memory_order_acquire);
+			if (!entry || (entry->hash == hash && name == entry->name))
+			{
+				return entry;
+			}
+		}
+	}
+	void insert(AtomEntry* entry)
+	{
+		size_t i = entry->hash & mask;
+		while (entries[i].load(std::memory_order_relaxed))
+		{
+			i = (i + 1) & mask;
+		}
+		entries[i].store(entry, std::memory_order_release);
+	}
+	size_t mask;
+	OwnArray<std::atomic<AtomEntry*>> entries;
+};
+
+/* Interned names are found without locking, the mutex is only taken to
+ add a name. Slots are replaced by a larger copy when half full, and the
+ replaced ones are kept alive since other threads may still be probing them. */
+struct AtomTable
+{
+	AtomTable()
+	{
+		oldSlots.push_back(Own<AtomSlots>(new AtomSlots(1024)));
+		slots.store(oldSlots.back(), std::memory_order_relaxed);
+		AtomTable::add("", hashName(""));
+	}
+	Uint32 add(String name, size_t hash)
+	{
+		AtomSlots* current = slots.load(std::memory_order_relaxed);
+		if ((names.size() + 1) * 2 > current->mask + 1)
+		{
+			Own<AtomSlots> larger(new AtomSlots((current->mask + 1) * 2));
+			for (const auto& entry : names)
+			{
+				larger->insert(entry);
+			}
+			current = larger;
+			oldSlots.push_back(std::move(larger));
+			slots.store(current, std::memory_order_release);
+		}
+		Uint32 id = s_cast<Uint32>(names.size());
+		names.push_back(Own<AtomEntry>(new AtomEntry{name.toString(), hash, id}));
+		current->insert(names.back());
+		return id;
+	}
+	bx::Mutex mutex;
+	std::atomic<AtomSlots*> slots;
+	vector<Own<AtomSlots>> oldSlots;
+	// indexed by ids, the entries never move
+	vector<Own<AtomEntry>> names;
+};
+
+// constructed on first use so that atoms can be interned by static initializers
+static AtomTable& getAtomTable()
+{
+	static AtomTable table;
+	return table;
+}
+
+Uint32 Atom::intern(String name)
+{
+	AtomTable& table = getAtomTable();
+	size_t hash = hashName(name);
+	AtomEntry* entry = table.slots.load(std::memory_order_acquire)->find(name, hash);
+	if (entry)
+	{
+		return entry->id;
+	}
+	bx::MutexScope lock(table.mutex);
+	// another thread may have added the name after the probe
+	entry = table.slots.load(std::memory_order_relaxed)->find(name, hash);
+	if (entry)
+	{
+		return entry->id;
+	}
+	return table.add(name, hash);
+}
+
+const string& Atom::getName(Uint32 id)
+{
+	AtomTable& table = getAtomTable();
+	bx::MutexScope lock(table.mutex);
+	AssertUnless(id < table.names.size(), "invalid atom id.");
+	return table.names[id]->name;
+}
+
+Uint32 Atom::getCount()
+{
+	AtomTable& table = getAtomTable();
+	bx::MutexScope lock(table.mutex);
+	return s_cast<Uint32>(table.names.size());
+}
+
+NS_DOROTHY_END
@@ -0,0 +1,32 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+NS_DOROTHY_BEGIN
+
+/** @brief Global table interning names into 32-bit ids,
+ so that names can be compared and used as array indices without hashing.
+ Id 0 is the empty name. Ids are dense and never released. Thread safe,
+ names already interned are found without locking.
+ @example Intern a name once and use the id on hot paths.
+ static const Uint32 AppQuit = Atom::intern("AppQuit");
+ Event::send(AppQuit);
+ */
+class Atom
+{
+public:
+	/** @brief Get the id of a name, interning the name on the first call. */
+	static Uint32 intern(String name);
+	/** @brief Get the name of an interned id, mostly for debugging. */
+	static const string& getName(Uint32 id);
+	/** @brief Count of interned names including the empty name. */
+	static Uint32 getCount();
+};
+
+NS_DOROTHY_END
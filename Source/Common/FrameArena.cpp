@@ -0,0 +1,116 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Common/FrameArena.h"
+
+NS_DOROTHY_BEGIN
+
+FrameArena::FrameArena(size_t chunkSize):
+_chunkSize(chunkSize),
+_current(0),
+_offset(0),
+_highWater(0)
+{ }
+
+FrameArena& FrameArena::getCurrent()
+{
+	return SharedPoolManager.getFrameArena();
+}
+
+FrameArena::~FrameArena()
+{
+	for (const Chunk& chunk : _chunks)
+	{
+		delete [] chunk.data;
+	}
+}
+
+size_t FrameArena::getUsed() const
+{
+	return _chunks.empty() ? 0 : _chunks[_current].base + _offset;
+}
+
+size_t FrameArena::getCapacity() const
+{
+	size_t capacity = 0;
+	for (const Chunk& chunk : _chunks)
+	{
+		capacity += chunk.size;
+	}
+	return capacity;
+}
+
+size_t FrameArena::getHighWater() const
+{
+	return _highWater;
+}
+
+FrameArena::Marker FrameArena::getMarker() const
+{
+	return {_current, _offset};
+}
+
+void* FrameArena::alloc(size_t size, size_t alignment)
+{
+	while (_current < _chunks.size())
+	{
+		Chunk& chunk = _chunks[_current];
+		uintptr_t address = r_cast<uintptr_t>(chunk.data) + _offset;
+		size_t padding = (alignment - address % alignment) % alignment;
+		if (_offset + padding + size <= chunk.size)
+		{
+			_offset += padding + size;
+			_highWater = max(_highWater, chunk.base + _offset);
+			return r_cast<void*>(address + padding);
+		}
+		if (_current + 1 == _chunks.size() || _chunks[_current + 1].size < size + alignment)
+		{
+			break;
+		}
+		// move to the next kept chunk
+		_chunks[_current + 1].base = chunk.base + _offset;
+		_current++;
+		_offset = 0;
+	}
+	// insert a new chunk after the current one, oversized requests get their own chunk
+	size_t base = _chunks.empty() ? 0 : _chunks[_current].base + _offset;
+	Chunk chunk = {new Uint8[max(_chunkSize, size + alignment)], max(_chunkSize, size + alignment), base};
+	size_t index = _chunks.empty() ? 0 : _current + 1;
+	_chunks.insert(_chunks.begin() + index, chunk);
+	_current = index;
+	_offset = 0;
+	return FrameArena::alloc(size, alignment);
+}
+
+void FrameArena::rewind(const Marker& marker)
+{
+	AssertIf(marker.chunk > _current || (marker.chunk == _current && marker.offset > _offset), "rewind frame arena to an invalid marker.");
+	_current = marker.chunk;
+	_offset = marker.offset;
+}
+
+void FrameArena::reset()
+{
+	_current = 0;
+	_offset = 0;
+}
+
+void FrameArena::shrink()
+{
+	for (size_t i = _current + 1; i < _chunks.size(); i++)
+	{
+		delete [] _chunks[i].data;
+	}
+	if (!_chunks.empty())
+	{
+		_chunks.erase(_chunks.begin() + _current + 1, _chunks.end());
+	}
+}
+
+NS_DOROTHY_END
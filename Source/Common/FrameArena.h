@@ -0,0 +1,122 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include <cstddef>
+
+NS_DOROTHY_BEGIN
+
+/** @brief Linear allocator for transient data of a frame.
+ Allocations bump an offset in a list of chunks and are never freed one by one,
+ the arena is rewound when the autorelease pool pushed before them is popped.
+ Destructors are not called on rewinding. Logic thread use only.
+ @example Allocate from the arena of the current frame.
+ FrameArena& arena = SharedPoolManager.getFrameArena();
+ float* vertices = arena.allocArray<float>(count);
+ FrameVector<Event*> events(arena);
+ FrameString path("Script/");
+ */
+class FrameArena
+{
+public:
+	/** @brief Position of an arena to rewind to. */
+	struct Marker
+	{
+		size_t chunk;
+		size_t offset;
+	};
+	FrameArena(size_t chunkSize = 64 * 1024);
+	~FrameArena();
+	/** @brief The arena owned by the shared pool manager. */
+	static FrameArena& getCurrent();
+	/** @brief Bytes allocated since the arena was reset. */
+	PROPERTY_READONLY(size_t, Used);
+	/** @brief Bytes of all the chunks. */
+	PROPERTY_READONLY(size_t, Capacity);
+	/** @brief Max used bytes ever reached. */
+	PROPERTY_READONLY(size_t, HighWater);
+	PROPERTY_READONLY(Marker, Marker);
+	void* alloc(size_t size, size_t alignment = alignof(std::max_align_t));
+	template<class T>
+	T* allocArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "type in frame arena must be trivially destructible.");
+		return r_cast<T*>(FrameArena::alloc(sizeof(T) * count, alignof(T)));
+	}
+	template<class T, class... Args>
+	T* make(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "type in frame arena must be trivially destructible.");
+		return new (FrameArena::alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+	/** @brief Release all allocations made after the marker. */
+	void rewind(const Marker& marker);
+	/** @brief Release all allocations and keep the chunks for reuse. */
+	void reset();
+	/** @brief Free the chunks not in use. */
+	void shrink();
+private:
+	struct Chunk
+	{
+		Uint8* data;
+		size_t size;
+		// bytes used in chunks before this one
+		size_t base;
+	};
+	size_t _chunkSize;
+	size_t _current;
+	size_t _offset;
+	size_t _highWater;
+	vector<Chunk> _chunks;
+};
+
+/** @brief STL allocator adaptor allocating from a frame arena,
+ containers using it must not outlive the frame. */
+template<class T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+	FrameAllocator():_arena(&FrameArena::getCurrent()) { }
+	FrameAllocator(FrameArena& arena):_arena(&arena) { }
+	template<class U>
+	FrameAllocator(const FrameAllocator<U>& other):_arena(other.getArena()) { }
+	inline T* allocate(size_t count)
+	{
+		return r_cast<T*>(_arena->alloc(sizeof(T) * count, alignof(T)));
+	}
+	inline void deallocate(T* pointer, size_t count)
+	{
+		DORA_UNUSED_PARAM(pointer);
+		DORA_UNUSED_PARAM(count);
+	}
+	inline FrameArena* getArena() const
+	{
+		return _arena;
+	}
+	template<class U>
+	inline bool operator==(const FrameAllocator<U>& other) const
+	{
+		return _arena == other.getArena();
+	}
+	template<class U>
+	inline bool operator!=(const FrameAllocator<U>& other) const
+	{
+		return _arena != other.getArena();
+	}
+private:
+	FrameArena* _arena;
+};
+
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+
+NS_DOROTHY_END
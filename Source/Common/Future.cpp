@@ -0,0 +1,72 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Common/Future.h"
+
+NS_DOROTHY_BEGIN
+
+FutureStateBase::FutureStateBase():
+_ready(false),
+_inLogic(true)
+{ }
+
+FutureStateBase::~FutureStateBase()
+{ }
+
+bool FutureStateBase::isReady() const
+{
+	return _ready;
+}
+
+void FutureStateBase::setContinuation(Task continuation, bool inLogic)
+{
+	{
+		bx::MutexScope lock(_mutex);
+		AssertIf(_continuation, "future can only be continued once.");
+		if (!_ready)
+		{
+			_continuation = std::move(continuation);
+			_inLogic = inLogic;
+			return;
+		}
+	}
+	FutureStateBase::dispatch(std::move(continuation), inLogic);
+}
+
+void FutureStateBase::resolve()
+{
+	Task continuation;
+	bool inLogic;
+	{
+		bx::MutexScope lock(_mutex);
+		_ready = true;
+		continuation = std::move(_continuation);
+		inLogic = _inLogic;
+	}
+	if (continuation)
+	{
+		FutureStateBase::dispatch(std::move(continuation), inLogic);
+	}
+}
+
+void FutureStateBase::dispatch(Task continuation, bool inLogic)
+{
+	// keep the state until the continuation is run
+	FutureStateBase::retain();
+	if (inLogic)
+	{
+		SharedJobSystem.runFinisher(std::move(continuation));
+	}
+	else
+	{
+		SharedJobSystem.run(std::move(continuation));
+	}
+}
+
+NS_DOROTHY_END
@@ -0,0 +1,225 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+NS_DOROTHY_BEGIN
+
+template<class T> class Future;
+template<class T> class Promise;
+
+/** @brief Inner class shared by a promise and its future,
+ states of all types are allocated from the block pools. */
+class FutureStateBase : public ThreadSafeObject
+{
+public:
+	PROPERTY_READONLY_BOOL(Ready);
+	/** @brief Run the continuation once the value is set,
+	 in logic thread or in a worker thread. The state is retained when
+	 the continuation is dispatched, the continuation must release it. */
+	void setContinuation(Task continuation, bool inLogic);
+protected:
+	FutureStateBase();
+	virtual ~FutureStateBase();
+	void resolve();
+	std::atomic<bool> _ready;
+private:
+	void dispatch(Task continuation, bool inLogic);
+	bool _inLogic;
+	bx::Mutex _mutex;
+	Task _continuation;
+	USE_BLOCK_POOL
+};
+
+/** @brief The value is stored inside the shared state,
+ no extra allocation is made for a result. */
+template<class T>
+class FutureState : public FutureStateBase
+{
+public:
+	virtual ~FutureState()
+	{
+		if (_ready)
+		{
+			getValue().~T();
+		}
+	}
+	inline T& getValue()
+	{
+		return *r_cast<T*>(&_storage);
+	}
+	template<class... Args>
+	void setValue(Args&&... args)
+	{
+		AssertIf(_ready, "future value can only be set once.");
+		new (&_storage) T(std::forward<Args>(args)...);
+		FutureStateBase::resolve();
+	}
+	template<class Func>
+	auto apply(Func& func) -> decltype(func(std::declval<T&>()))
+	{
+		return func(getValue());
+	}
+private:
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+};
+
+template<>
+class FutureState<void> : public FutureStateBase
+{
+public:
+	void setValue()
+	{
+		AssertIf(_ready, "future value can only be set once.");
+		FutureStateBase::resolve();
+	}
+	template<class Func>
+	auto apply(Func& func) -> decltype(func())
+	{
+		return func();
+	}
+};
+
+template<class T, class Func>
+struct FutureApply
+{
+	typedef typename std::decay<decltype(std::declval<Func&>()(std::declval<T&>()))>::type type;
+};
+
+template<class Func>
+struct FutureApply<void, Func>
+{
+	typedef typename std::decay<decltype(std::declval<Func&>()())>::type type;
+};
+
+template<class T>
+struct FutureSetter
+{
+	template<class Func>
+	static void set(FutureState<T>* state, Func& func)
+	{
+		state->setValue(func());
+	}
+};
+
+template<>
+struct FutureSetter<void>
+{
+	template<class Func>
+	static void set(FutureState<void>* state, Func& func)
+	{
+		func();
+		state->setValue();
+	}
+};
+
+/** @brief Write end of a future, can be set from any thread. */
+template<class T>
+class Promise
+{
+public:
+	Promise():_state(new FutureState<T>())
+	{ }
+	inline Future<T> getFuture() const
+	{
+		return Future<T>(_state);
+	}
+	template<class... Args>
+	void set(Args&&... args)
+	{
+		_state->setValue(std::forward<Args>(args)...);
+	}
+	/** @brief Set the value with the result of the function. */
+	template<class Func>
+	void setWith(Func& func)
+	{
+		FutureSetter<T>::set(_state, func);
+	}
+private:
+	Ref<FutureState<T>> _state;
+};
+
+/** @brief Task continuing a future, the callable is moved in instead of
+ being copied into a capture. The state owns the continuation, so it is not referenced here. */
+template<class T, class R, class Continuation>
+struct FutureContinuation
+{
+	FutureState<T>* state;
+	Promise<R> promise;
+	Continuation continuation;
+	void operator()()
+	{
+		auto call = [&]() { return state->apply(continuation); };
+		promise.setWith(call);
+		state->release();
+	}
+};
+
+/** @brief Read end of a typed result produced in another thread.
+ @example Use it as below.
+
+ Async::FileIO.run([]()
+ {
+ 	return decodeImage("a.png");
+ })
+ .thenAsync([](Image& image)
+ {
+ 	// still in a worker thread
+ 	return buildMipmaps(image);
+ })
+ .then([](Texture& texture)
+ {
+ 	// now in logic thread
+ 	sprite->setTexture(texture);
+ });
+ */
+template<class T>
+class Future
+{
+public:
+	Future() { }
+	explicit Future(FutureState<T>* state):_state(state)
+	{ }
+	inline bool isValid() const
+	{
+		return _state != nullptr;
+	}
+	inline bool isReady() const
+	{
+		return _state && _state->isReady();
+	}
+	/** @brief Continue in logic thread with the value,
+	 get a future of what the continuation returns. */
+	template<class Func>
+	Future<typename FutureApply<T, Func>::type> then(Func&& func)
+	{
+		return Future::chain(std::forward<Func>(func), true);
+	}
+	/** @brief Continue in a worker thread with the value. */
+	template<class Func>
+	Future<typename FutureApply<T, Func>::type> thenAsync(Func&& func)
+	{
+		return Future::chain(std::forward<Func>(func), false);
+	}
+private:
+	template<class Func>
+	Future<typename FutureApply<T, Func>::type> chain(Func&& func, bool inLogic)
+	{
+		AssertUnless(_state, "continue an invalid future.");
+		typedef typename FutureApply<T, Func>::type R;
+		typedef typename std::decay<Func>::type Continuation;
+		Promise<R> promise;
+		Future<R> future = promise.getFuture();
+		_state->setContinuation(FutureContinuation<T, R, Continuation>{
+			_state.get(), std::move(promise), std::forward<Func>(func)}, inLogic);
+		return future;
+	}
+	Ref<FutureState<T>> _state;
+};
+
+NS_DOROTHY_END
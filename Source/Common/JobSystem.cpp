@@ -0,0 +1,392 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Common/JobSystem.h"
+#include "bx/timer.h"
+#include "bx/os.h"
+
+NS_DOROTHY_BEGIN
+
+struct Job
+{
+	JobSystem::Work work;
+	JobSystem::Work finisher;
+	Ref<JobCounter> counter;
+	Uint64 finishTime;
+	Job* next;
+	USE_BLOCK_POOL
+};
+
+// index of the worker running in current thread, -1 for other threads
+static thread_local int g_workerIndex = -1;
+
+JobCounter::JobCounter():
+_value(0)
+{ }
+
+JobCounter::~JobCounter()
+{
+	for (Job* job : _waitingJobs)
+	{
+		JobCounter::drop(job);
+	}
+}
+
+void JobCounter::drop(Job* job)
+{
+	// a dropped job is counted as done, so that nothing waits for it forever
+	Ref<JobCounter> counter = job->counter;
+	delete job;
+	if (counter)
+	{
+		vector<Job*> readyJobs;
+		counter->decrease(readyJobs);
+		for (Job* readyJob : readyJobs)
+		{
+			JobCounter::drop(readyJob);
+		}
+	}
+}
+
+int JobCounter::getValue() const
+{
+	return _value;
+}
+
+bool JobCounter::isDone() const
+{
+	return _value == 0;
+}
+
+void JobCounter::increase()
+{
+	bx::MutexScope lock(_mutex);
+	++_value;
+}
+
+void JobCounter::decrease(vector<Job*>& readyJobs)
+{
+	bx::MutexScope lock(_mutex);
+	if (--_value == 0)
+	{
+		readyJobs.swap(_waitingJobs);
+	}
+}
+
+bool JobCounter::wait(Job* job)
+{
+	bx::MutexScope lock(_mutex);
+	if (_value == 0)
+	{
+		return false;
+	}
+	_waitingJobs.push_back(job);
+	return true;
+}
+
+JobSystem::JobSystem():
+_finisherBudget(0.002),
+_running(false),
+_stopping(false),
+_nextWorker(0),
+_backlog(0),
+_maxBacklog(0),
+_averageLatency(0),
+_maxLatency(0),
+_finishedHead(nullptr),
+_finishedTail(nullptr)
+{ }
+
+JobSystem::~JobSystem()
+{
+	JobSystem::shutdown();
+}
+
+int JobSystem::getWorkerCount() const
+{
+	return (int)_workers.size();
+}
+
+void JobSystem::setFinisherBudget(double var)
+{
+	_finisherBudget = max(var, 0.0);
+}
+
+double JobSystem::getFinisherBudget() const
+{
+	return _finisherBudget;
+}
+
+int JobSystem::getBacklog() const
+{
+	return _backlog;
+}
+
+int JobSystem::getMaxBacklog() const
+{
+	return _maxBacklog;
+}
+
+double JobSystem::getAverageLatency() const
+{
+	return _averageLatency;
+}
+
+double JobSystem::getMaxLatency() const
+{
+	return _maxLatency;
+}
+
+void JobSystem::startup()
+{
+	// leave one core for the render thread, logic thread helps when waiting
+	int workerCount = max(2, SDL_GetCPUCount() - 1);
+	for (int i = 0; i < workerCount; i++)
+	{
+		Own<Worker> worker(new Worker());
+		worker->owner = this;
+		worker->index = i;
+		_workers.push_back(std::move(worker));
+	}
+	for (const auto& worker : _workers)
+	{
+		worker->thread.init(JobSystem::work, worker.get(), 0, "Dorothy Worker");
+	}
+	SharedDirector.getSystemScheduler()->schedule([this](double deltaTime)
+	{
+		DORA_UNUSED_PARAM(deltaTime);
+		JobSystem::finish();
+		return !_running;
+	});
+	_running = true;
+}
+
+void JobSystem::shutdown()
+{
+	if (!_running)
+	{
+		return;
+	}
+	_stopping = true;
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		_semaphore.post();
+	}
+	for (const auto& worker : _workers)
+	{
+		worker->thread.shutdown();
+		for (Job* job : worker->jobs)
+		{
+			JobCounter::drop(job);
+		}
+	}
+	_workers.clear();
+	for (Job* job = JobSystem::popFinished(); job; job = JobSystem::popFinished())
+	{
+		delete job;
+	}
+	_stopping = false;
+	_running = false;
+}
+
+void JobSystem::run(Work work, Work finisher, JobCounter* counter, JobCounter* dependency)
+{
+	if (!_running)
+	{
+		JobSystem::startup();
+	}
+	Job* job = new Job{std::move(work), std::move(finisher), Ref<JobCounter>(counter), 0, nullptr};
+	if (counter)
+	{
+		counter->increase();
+	}
+	if (dependency && dependency->wait(job))
+	{
+		return;
+	}
+	JobSystem::push(job);
+}
+
+void JobSystem::runFinisher(Work finisher)
+{
+	if (!_running)
+	{
+		JobSystem::startup();
+	}
+	++_backlog;
+	JobSystem::pushFinished(new Job{nullptr, std::move(finisher), Ref<JobCounter>(), s_cast<Uint64>(bx::getHPCounter()), nullptr});
+}
+
+void JobSystem::pushFinished(Job* job)
+{
+	bx::MutexScope lock(_finishedMutex);
+	if (_finishedTail)
+	{
+		_finishedTail->next = job;
+	}
+	else
+	{
+		_finishedHead = job;
+	}
+	_finishedTail = job;
+}
+
+Job* JobSystem::popFinished()
+{
+	bx::MutexScope lock(_finishedMutex);
+	Job* job = _finishedHead;
+	if (job)
+	{
+		_finishedHead = job->next;
+		if (!_finishedHead)
+		{
+			_finishedTail = nullptr;
+		}
+		job->next = nullptr;
+	}
+	return job;
+}
+
+void JobSystem::push(Job* job)
+{
+	int index = g_workerIndex;
+	Worker* worker = index >= 0 ? _workers[index].get() :
+		_workers[_nextWorker++ % _workers.size()].get();
+	{
+		bx::MutexScope lock(worker->mutex);
+		worker->jobs.push_back(job);
+	}
+	_semaphore.post();
+}
+
+Job* JobSystem::pop(int index)
+{
+	Worker* worker = _workers[index].get();
+	bx::MutexScope lock(worker->mutex);
+	if (worker->jobs.empty())
+	{
+		return nullptr;
+	}
+	Job* job = worker->jobs.back();
+	worker->jobs.pop_back();
+	return job;
+}
+
+Job* JobSystem::steal(int index)
+{
+	int count = (int)_workers.size();
+	for (int i = 1; i <= count; i++)
+	{
+		Worker* victim = _workers[(index + i + count) % count].get();
+		bx::MutexScope lock(victim->mutex);
+		if (!victim->jobs.empty())
+		{
+			Job* job = victim->jobs.front();
+			victim->jobs.pop_front();
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(Job* job)
+{
+	if (job->work)
+	{
+		job->work();
+	}
+	Ref<JobCounter> counter = job->counter;
+	if (job->finisher)
+	{
+		job->finishTime = bx::getHPCounter();
+		++_backlog;
+		JobSystem::pushFinished(job);
+	}
+	else
+	{
+		delete job;
+	}
+	if (counter)
+	{
+		vector<Job*> readyJobs;
+		counter->decrease(readyJobs);
+		for (Job* readyJob : readyJobs)
+		{
+			JobSystem::push(readyJob);
+		}
+	}
+}
+
+void JobSystem::wait(JobCounter* counter)
+{
+	while (counter && !counter->isDone())
+	{
+		int index = g_workerIndex;
+		Job* job = index >= 0 ? JobSystem::pop(index) : nullptr;
+		if (!job)
+		{
+			job = JobSystem::steal(index);
+		}
+		if (job)
+		{
+			JobSystem::execute(job);
+		}
+		else
+		{
+			bx::yield();
+		}
+	}
+}
+
+void JobSystem::finish()
+{
+	_maxBacklog = max(_maxBacklog, _backlog.load());
+	double frequency = double(bx::getHPFrequency());
+	Uint64 startTime = bx::getHPCounter();
+	for (Own<Job> job(JobSystem::popFinished());
+		job != nullptr;
+		job = Own<Job>(JobSystem::popFinished()))
+	{
+		--_backlog;
+		double latency = (bx::getHPCounter() - job->finishTime) / frequency;
+		_averageLatency = _averageLatency * 0.9 + latency * 0.1;
+		_maxLatency = max(_maxLatency, latency);
+		job->finisher();
+		if ((bx::getHPCounter() - startTime) / frequency >= _finisherBudget)
+		{
+			break;
+		}
+	}
+}
+
+int JobSystem::work(void* userData)
+{
+	Worker* worker = r_cast<Worker*>(userData);
+	JobSystem* system = worker->owner;
+	g_workerIndex = worker->index;
+	while (!system->_stopping)
+	{
+		Job* job = system->pop(worker->index);
+		if (!job)
+		{
+			job = system->steal(worker->index);
+		}
+		if (job)
+		{
+			system->execute(job);
+		}
+		else
+		{
+			system->_semaphore.wait();
+		}
+	}
+	return 0;
+}
+
+NS_DOROTHY_END
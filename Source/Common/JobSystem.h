@@ -0,0 +1,202 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include <deque>
+
+NS_DOROTHY_BEGIN
+
+struct Job;
+
+/** @brief Move only callable for works of jobs, the callable is kept in
+ a pooled block instead of the heap memory taken by a function object. */
+class Task
+{
+public:
+	Task():_handler(nullptr), _callable(nullptr)
+	{ }
+	Task(std::nullptr_t):Task()
+	{ }
+	template<class Func, class = typename std::enable_if<
+		!std::is_same<typename std::decay<Func>::type, Task>::value>::type>
+	Task(Func&& func):Task()
+	{
+		typedef typename std::decay<Func>::type Callable;
+		static_assert(alignof(Callable) <= 16, "callable of a task is over aligned.");
+		if (!Task::isEmpty(func))
+		{
+			_callable = new (BlockPool::alloc(sizeof(Callable))) Callable(std::forward<Func>(func));
+			_handler = &Task::handle<Callable>;
+		}
+	}
+	Task(Task&& other):_handler(other._handler), _callable(other._callable)
+	{
+		other._handler = nullptr;
+		other._callable = nullptr;
+	}
+	~Task()
+	{
+		Task::reset();
+	}
+	Task& operator=(Task&& other)
+	{
+		if (this != &other)
+		{
+			Task::reset();
+			std::swap(_handler, other._handler);
+			std::swap(_callable, other._callable);
+		}
+		return *this;
+	}
+	explicit operator bool() const
+	{
+		return _callable != nullptr;
+	}
+	void operator()()
+	{
+		_handler(_callable, true);
+	}
+	void reset()
+	{
+		if (_callable)
+		{
+			_handler(_callable, false);
+			_handler = nullptr;
+			_callable = nullptr;
+		}
+	}
+private:
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	template<class Callable>
+	static bool isEmpty(const Callable&)
+	{
+		return false;
+	}
+	template<class Signature>
+	static bool isEmpty(const function<Signature>& func)
+	{
+		return !func;
+	}
+	template<class Callable>
+	static void handle(void* callable, bool call)
+	{
+		Callable* func = s_cast<Callable*>(callable);
+		if (call)
+		{
+			(*func)();
+		}
+		else
+		{
+			func->~Callable();
+			BlockPool::free(callable, sizeof(Callable));
+		}
+	}
+	void (*_handler)(void* callable, bool call);
+	void* _callable;
+};
+
+/** @brief Counts unfinished jobs, jobs can be set to start only after
+ a counter drops to zero. Used with Ref<JobCounter>, thread safe. */
+class JobCounter : public ThreadSafeObject
+{
+public:
+	JobCounter();
+	virtual ~JobCounter();
+	PROPERTY_READONLY(int, Value);
+	PROPERTY_READONLY_BOOL(Done);
+private:
+	void increase();
+	void decrease(vector<Job*>& readyJobs);
+	bool wait(Job* job);
+	static void drop(Job* job);
+	std::atomic<int> _value;
+	bx::Mutex _mutex;
+	vector<Job*> _waitingJobs;
+	friend class JobSystem;
+};
+
+/** @brief Runs works on worker threads sized to the hardware.
+ Every worker owns a job deque, takes its own newest jobs first and
+ steals the oldest jobs from other workers when idle.
+ Finishers of jobs are run in the logic thread by the system scheduler.
+ @example Use it as below.
+
+ Ref<JobCounter> counter(new JobCounter());
+ SharedJobSystem.run([]() { loadA(); }, nullptr, counter);
+ SharedJobSystem.run([]() { loadB(); }, nullptr, counter);
+ // starts after both loadA and loadB are done
+ SharedJobSystem.run([]() { link(); }, []() { Log("linked"); }, nullptr, counter);
+ */
+class JobSystem
+{
+public:
+	typedef Task Work;
+	virtual ~JobSystem();
+	PROPERTY_READONLY(int, WorkerCount);
+	/** @brief Max time in seconds spent running finishers each frame,
+	 at least one finisher is run per frame. */
+	PROPERTY(double, _finisherBudget, FinisherBudget);
+	/** @brief Count of finished jobs waiting for their finishers. */
+	PROPERTY_READONLY(int, Backlog);
+	PROPERTY_READONLY(int, MaxBacklog);
+	/** @brief Time between a job finished and its finisher was run. */
+	PROPERTY_READONLY(double, AverageLatency);
+	PROPERTY_READONLY(double, MaxLatency);
+	/** @brief Run a work in worker thread then run the finisher in logic thread.
+	 @param counter is increased now and decreased when the work is done.
+	 @param dependency the work starts when this counter drops to zero. */
+	void run(Work work, Work finisher = nullptr,
+		JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+	/** @brief Run the finisher in logic thread without a work,
+	 can be called from any thread. */
+	void runFinisher(Work finisher);
+	/** @brief Help running jobs until the counter drops to zero. */
+	void wait(JobCounter* counter);
+	/** @brief Run finishers within the finisher budget, called each frame. */
+	void finish();
+	void shutdown();
+protected:
+	JobSystem();
+	struct Worker
+	{
+		JobSystem* owner;
+		int index;
+		bx::Thread thread;
+		bx::Mutex mutex;
+		std::deque<Job*> jobs;
+	};
+	void startup();
+	void push(Job* job);
+	Job* pop(int index);
+	Job* steal(int index);
+	void execute(Job* job);
+	void pushFinished(Job* job);
+	Job* popFinished();
+	static int work(void* userData);
+private:
+	bool _running;
+	std::atomic<bool> _stopping;
+	std::atomic<Uint32> _nextWorker;
+	std::atomic<int> _backlog;
+	int _maxBacklog;
+	double _averageLatency;
+	double _maxLatency;
+	bx::Semaphore _semaphore;
+	vector<Own<Worker>> _workers;
+	// finished jobs are linked through themselves, so pushing allocates nothing
+	bx::Mutex _finishedMutex;
+	Job* _finishedHead;
+	Job* _finishedTail;
+};
+
+#define SharedJobSystem \
+	silly::Singleton<JobSystem, SingletonIndex::JobSystem>::shared()
+
+NS_DOROTHY_END
@@ -0,0 +1,175 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+NS_DOROTHY_BEGIN
+
+/** @brief Codec of the LZ4 block format, shared by the engine and the pack tool.
+ Blocks are compatible with LZ4_compress_default and LZ4_decompress_safe,
+ the compressor is a simple greedy one and decoding is much cheaper than inflating. */
+namespace Lz4
+{
+	static const size_t MinMatch = 4;
+	// the last bytes of a block are always literals
+	static const size_t LastLiterals = 5;
+	static const size_t MatchFindLimit = 12;
+	static const size_t MaxOffset = 65535;
+	static const int HashBits = 16;
+
+	inline size_t compressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	inline uint32_t read32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint8_t* writeLength(uint8_t* output, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+		{
+			*output++ = 255;
+		}
+		*output++ = static_cast<uint8_t>(length);
+		return output;
+	}
+
+	/** @brief Compress into output with at least compressBound(size) bytes.
+	 @return size of the compressed block. */
+	inline size_t compress(const uint8_t* input, size_t size, uint8_t* output)
+	{
+		const uint8_t* end = input + size;
+		const uint8_t* anchor = input;
+		uint8_t* out = output;
+		if (size >= MatchFindLimit + 1)
+		{
+			std::vector<uint32_t> table(size_t(1) << HashBits, UINT32_MAX);
+			const uint8_t* matchLimit = end - LastLiterals;
+			const uint8_t* findLimit = end - MatchFindLimit;
+			const uint8_t* current = input;
+			while (current <= findLimit)
+			{
+				uint32_t sequence = read32(current);
+				uint32_t hash = (sequence * 2654435761U) >> (32 - HashBits);
+				uint32_t candidate = table[hash];
+				table[hash] = static_cast<uint32_t>(current - input);
+				if (candidate == UINT32_MAX || static_cast<size_t>(current - input) - candidate > MaxOffset
+					|| read32(input + candidate) != sequence)
+				{
+					current++;
+					continue;
+				}
+				const uint8_t* match = input + candidate;
+				while (current > anchor && match > input && current[-1] == match[-1])
+				{
+					current--;
+					match--;
+				}
+				const uint8_t* matchEnd = current + MinMatch;
+				for (const uint8_t* from = match + MinMatch; matchEnd < matchLimit && *matchEnd == *from; from++)
+				{
+					matchEnd++;
+				}
+				size_t literalLength = current - anchor;
+				size_t matchLength = matchEnd - current - MinMatch;
+				uint8_t* token = out++;
+				*token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+				if (literalLength >= 15) out = writeLength(out, literalLength - 15);
+				memcpy(out, anchor, literalLength);
+				out += literalLength;
+				size_t offset = current - match;
+				*out++ = static_cast<uint8_t>(offset);
+				*out++ = static_cast<uint8_t>(offset >> 8);
+				*token |= static_cast<uint8_t>(matchLength >= 15 ? 15 : matchLength);
+				if (matchLength >= 15) out = writeLength(out, matchLength - 15);
+				current = anchor = matchEnd;
+			}
+		}
+		size_t literalLength = end - anchor;
+		*out++ = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+		if (literalLength >= 15) out = writeLength(out, literalLength - 15);
+		if (literalLength > 0) memcpy(out, anchor, literalLength);
+		out += literalLength;
+		return out - output;
+	}
+
+	/** @brief Decompress a block of untrusted data into exactly size bytes.
+	 @return false for a malformed block. */
+	inline bool decompress(const uint8_t* input, size_t inputSize, uint8_t* output, size_t size)
+	{
+		const uint8_t* in = input;
+		const uint8_t* inEnd = input + inputSize;
+		uint8_t* out = output;
+		uint8_t* outEnd = output + size;
+		while (in < inEnd)
+		{
+			uint8_t token = *in++;
+			size_t literalLength = token >> 4;
+			if (literalLength == 15)
+			{
+				uint8_t extra;
+				do
+				{
+					if (in >= inEnd) return false;
+					extra = *in++;
+					literalLength += extra;
+				} while (extra == 255);
+			}
+			if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out))
+			{
+				return false;
+			}
+			if (literalLength > 0) memcpy(out, in, literalLength);
+			in += literalLength;
+			out += literalLength;
+			// the last sequence has no match
+			if (in == inEnd) break;
+			if (inEnd - in < 2) return false;
+			size_t offset = in[0] | (in[1] << 8);
+			in += 2;
+			if (offset == 0 || offset > static_cast<size_t>(out - output)) return false;
+			size_t matchLength = token & 15;
+			if (matchLength == 15)
+			{
+				uint8_t extra;
+				do
+				{
+					if (in >= inEnd) return false;
+					extra = *in++;
+					matchLength += extra;
+				} while (extra == 255);
+			}
+			matchLength += MinMatch;
+			if (matchLength > static_cast<size_t>(outEnd - out)) return false;
+			const uint8_t* match = out - offset;
+			if (offset >= matchLength)
+			{
+				memcpy(out, match, matchLength);
+				out += matchLength;
+			}
+			else
+			{
+				// overlapped matches repeat the last offset bytes
+				for (size_t i = 0; i < matchLength; i++) *out++ = *match++;
+			}
+		}
+		return out == outEnd;
+	}
+}
+
+NS_DOROTHY_END
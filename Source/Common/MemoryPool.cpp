@@ -0,0 +1,206 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "Common/MemoryPool.h"
+#include "bx/timer.h"
+
+NS_DOROTHY_BEGIN
+
+// items and chunks to process in a frame, more when the frame has idle time
+static const int ShrinkBudget = 256;
+static const int IdleShrinkBudget = 4096;
+static const double IdleTimeThreshold = 0.001;
+static const double AllocRateInterval = 1.0;
+
+// pools are mostly created with static storage before the logic thread starts
+static vector<MemoryPoolBase*>& getPools()
+{
+	static vector<MemoryPoolBase*> pools;
+	return pools;
+}
+
+static vector<MemoryPoolBase*>& getShrinkingPools()
+{
+	static vector<MemoryPoolBase*> pools;
+	return pools;
+}
+
+MemoryPoolBase::MemoryPoolBase(String name, int itemSize, int chunkCapacity):
+_carvedCount(0),
+_chunkCount(0),
+_name(name),
+_itemSize(itemSize),
+_chunkCapacity(chunkCapacity),
+_itemCount(0),
+_highWater(0),
+_allocCount(0),
+_sampleAllocCount(0),
+_sampleTime(bx::getHPCounter()),
+_allocRate(0)
+{
+	// construct the lists before any pool so that they are destroyed after them
+	getShrinkingPools();
+	getPools().push_back(this);
+}
+
+MemoryPoolBase::~MemoryPoolBase()
+{
+	vector<MemoryPoolBase*>& shrinkingPools = getShrinkingPools();
+	shrinkingPools.erase(std::remove(shrinkingPools.begin(), shrinkingPools.end(), this), shrinkingPools.end());
+	vector<MemoryPoolBase*>& pools = getPools();
+	pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+}
+
+const string& MemoryPoolBase::getName() const
+{
+	return _name;
+}
+
+int MemoryPoolBase::getItemSize() const
+{
+	return _itemSize;
+}
+
+int MemoryPoolBase::getItemCount() const
+{
+	return _itemCount.load(std::memory_order_relaxed);
+}
+
+int MemoryPoolBase::getFreeCount() const
+{
+	return max(_carvedCount.load(std::memory_order_relaxed) - _itemCount.load(std::memory_order_relaxed), 0);
+}
+
+int MemoryPoolBase::getChunkCount() const
+{
+	return _chunkCount.load(std::memory_order_relaxed);
+}
+
+int MemoryPoolBase::getCapacity() const
+{
+	return _chunkCount.load(std::memory_order_relaxed) * _chunkCapacity;
+}
+
+int MemoryPoolBase::getHighWater() const
+{
+	return _highWater.load(std::memory_order_relaxed);
+}
+
+double MemoryPoolBase::getAllocRate() const
+{
+	Uint64 time = bx::getHPCounter();
+	double interval = (time - _sampleTime) / double(bx::getHPFrequency());
+	if (interval >= AllocRateInterval)
+	{
+		Uint32 allocCount = _allocCount.load(std::memory_order_relaxed);
+		_allocRate = (allocCount - _sampleAllocCount) / interval;
+		_sampleAllocCount = allocCount;
+		_sampleTime = time;
+	}
+	return _allocRate;
+}
+
+int MemoryPoolBase::getCount()
+{
+	return s_cast<int>(getPools().size());
+}
+
+MemoryPoolBase* MemoryPoolBase::getPool(int index)
+{
+	vector<MemoryPoolBase*>& pools = getPools();
+	if (index < 0 || index >= s_cast<int>(pools.size()))
+	{
+		return nullptr;
+	}
+	return pools[index];
+}
+
+int MemoryPoolBase::getTotalCapacity()
+{
+	int capacity = 0;
+	for (MemoryPoolBase* pool : getPools())
+	{
+		capacity += pool->getCapacity();
+	}
+	return capacity;
+}
+
+void MemoryPoolBase::shrinkAsync()
+{
+	vector<MemoryPoolBase*>& pools = getShrinkingPools();
+	if (std::find(pools.begin(), pools.end(), this) != pools.end())
+	{
+		return;
+	}
+	pools.push_back(this);
+	if (pools.size() > 1)
+	{
+		return;
+	}
+	SharedDirector.getSystemScheduler()->schedule([](double deltaTime)
+	{
+		DORA_UNUSED_PARAM(deltaTime);
+		vector<MemoryPoolBase*>& pools = getShrinkingPools();
+		if (!pools.empty())
+		{
+			int budget = SharedApplication.getIdleTime() > IdleTimeThreshold ? IdleShrinkBudget : ShrinkBudget;
+			if (pools.front()->shrink(budget))
+			{
+				pools.erase(pools.begin());
+			}
+		}
+		return pools.empty();
+	});
+}
+
+template<int Size>
+struct Block
+{
+	typename std::aligned_storage<Size, 16>::type data;
+};
+
+struct BlockPools
+{
+	MemoryPool<Block<32>> pool32{"Block32"};
+	MemoryPool<Block<64>> pool64{"Block64"};
+	MemoryPool<Block<128>> pool128{"Block128"};
+	MemoryPool<Block<256>> pool256{"Block256"};
+};
+
+static BlockPools& getBlockPools()
+{
+	// never destroyed, blocks are still freed by objects with static storage at exit
+	static BlockPools* pools = new BlockPools();
+	return *pools;
+}
+
+// made with static storage before worker threads start, since the registry is not locked
+static BlockPools& g_blockPools = getBlockPools();
+
+void* BlockPool::alloc(size_t size)
+{
+	BlockPools& pools = getBlockPools();
+	if (size <= 32) return pools.pool32.alloc();
+	if (size <= 64) return pools.pool64.alloc();
+	if (size <= 128) return pools.pool128.alloc();
+	if (size <= 256) return pools.pool256.alloc();
+	return ::operator new(size);
+}
+
+void BlockPool::free(void* addr, size_t size)
+{
+	BlockPools& pools = getBlockPools();
+	if (size <= 32) pools.pool32.free(addr);
+	else if (size <= 64) pools.pool64.free(addr);
+	else if (size <= 128) pools.pool128.free(addr);
+	else if (size <= 256) pools.pool256.free(addr);
+	else ::operator delete(addr);
+}
+
+NS_DOROTHY_END
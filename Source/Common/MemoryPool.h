@@ -8,23 +8,113 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #pragma once
 
-#include "Common/Define.h"
 #include <utility>
 #include <new>
+#include <typeinfo>
+#include <limits>
 
 NS_DOROTHY_BEGIN
 
+/** @brief Interface of memory pools for shrinking them across frames
+ and for reading their statistics. Every pool is kept in a registry. */
+class MemoryPoolBase
+{
+public:
+	MemoryPoolBase(String name, int itemSize, int chunkCapacity);
+	virtual ~MemoryPoolBase();
+	PROPERTY_READONLY_REF(string, Name);
+	PROPERTY_READONLY(int, ItemSize);
+	/** @brief Count of items in use. */
+	PROPERTY_READONLY(int, ItemCount);
+	/** @brief Count of carved items not in use, including the ones cached by threads. */
+	PROPERTY_READONLY(int, FreeCount);
+	PROPERTY_READONLY(int, ChunkCount);
+	/** @brief Bytes of memory taken by the chunks. */
+	PROPERTY_READONLY(int, Capacity);
+	/** @brief Max count of items ever in use at the same time. */
+	PROPERTY_READONLY(int, HighWater);
+	/** @brief Allocations per second, sampled about every second when read. */
+	PROPERTY_READONLY(double, AllocRate);
+	/** @brief Count of pools in the registry. */
+	PROPERTY_READONLY_CLASS(int, Count);
+	static MemoryPoolBase* getPool(int index);
+	/** @brief Sum of the memory taken by all the pools. */
+	static int getTotalCapacity();
+	/** @brief Shrink by processing about budget free items and chunks.
+	 @return true when a full shrink pass is done. */
+	virtual bool shrink(int budget) = 0;
+	/** @brief Shrink a little in the idle time of each frame until done. */
+	void shrinkAsync();
+protected:
+	inline void countAlloc()
+	{
+		int itemCount = _itemCount.fetch_add(1, std::memory_order_relaxed) + 1;
+		_allocCount.fetch_add(1, std::memory_order_relaxed);
+		int highWater = _highWater.load(std::memory_order_relaxed);
+		while (itemCount > highWater && !_highWater.compare_exchange_weak(
+			highWater, itemCount, std::memory_order_relaxed));
+	}
+	inline void countFree()
+	{
+		_itemCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	// changed with the mutex of the pool held
+	std::atomic<int> _carvedCount;
+	std::atomic<int> _chunkCount;
+private:
+	string _name;
+	int _itemSize;
+	int _chunkCapacity;
+	std::atomic<int> _itemCount;
+	std::atomic<int> _highWater;
+	std::atomic<Uint32> _allocCount;
+	mutable Uint32 _sampleAllocCount;
+	mutable Uint64 _sampleTime;
+	mutable double _allocRate;
+};
+
+/** @brief Pool allocator for objects of a type, safe to use from any thread.
+ Every thread keeps a magazine of free items to allocate and free without locking,
+ full magazines are exchanged between threads through a batch stack pushed without locking,
+ so items freed in a thread other than the allocating one are reused.
+ New chunks are carved under a mutex a batch at a time.
+ There should be only one pool for each instantiation of the template. */
 template<class Item, int CHUNK_CAPACITY = 4096, int WARNING_SIZE = 1024>// 4KB 1024KB
-class MemoryPool
+class MemoryPool : public MemoryPoolBase
 {
-#define ITEM_SIZE sizeof(Item)
+	struct FreeList
+	{
+		FreeList* next;
+		FreeList* nextBatch;
+	};
+	enum
+	{
+		ItemSize = sizeof(Item) > sizeof(FreeList) ? sizeof(Item) : sizeof(FreeList),
+		ChunkItems = CHUNK_CAPACITY / ItemSize,
+		BatchSize = ChunkItems < 32 ? ChunkItems : 32
+	};
+	struct Magazine
+	{
+		~Magazine()
+		{
+			if (pool) pool->flush(*this);
+		}
+		MemoryPool* pool;
+		FreeList* items;
+		int count;
+	};
 public:
-	MemoryPool() :
-		_chunk(new Chunk()),
-		_freeList(nullptr)
+	MemoryPool(String name = typeid(Item).name()) :
+		MemoryPoolBase(name, ItemSize, CHUNK_CAPACITY),
+		_chunk(nullptr),
+		_batches(nullptr),
+		_shrinkState(ShrinkState::Idle),
+		_shrinkItems(nullptr),
+		_shrinkBatches(nullptr),
+		_shrinkPrev(nullptr)
 	{
-		static_assert(ITEM_SIZE >= sizeof(intptr_t),
-			"Size of pool item must be greater or equal to the size of a pointer.");
+		static_assert(ChunkItems > 0, "Size of pool item must be less than the chunk capacity.");
+		MemoryPool::addChunk();
 	}
 	~MemoryPool()
 	{
@@ -32,131 +122,269 @@ public:
 	}
 	void* alloc()
 	{
-		if (_freeList)
-		{
-			FreeList* head = _freeList;
-			_freeList = _freeList->next;
-			return r_cast<void*>(head);
-		}
-		else
+		Magazine& magazine = MemoryPool::getMagazine();
+		if (!magazine.items)
 		{
-			if (_chunk->size + ITEM_SIZE > CHUNK_CAPACITY)
-			{
-				_chunk = new Chunk(_chunk);
-				int consumption = MemoryPool::capacity();
-				if (consumption > WARNING_SIZE * 1024)
-				{
-					oLog("[WARNING] MemoryPool consumes %d KB memory larger than %d KB for type %s",
-						consumption / 1024, WARNING_SIZE, typeid(Item).name());
-				}
-			}
-			char* addr = _chunk->buffer + _chunk->size;
-			_chunk->size += ITEM_SIZE;
-			return r_cast<void*>(addr);
+			MemoryPool::refill(magazine);
 		}
+		FreeList* head = magazine.items;
+		magazine.items = head->next;
+		magazine.count--;
+		MemoryPoolBase::countAlloc();
+		return r_cast<void*>(head);
 	}
 	void free(void* addr)
 	{
+		Magazine& magazine = MemoryPool::getMagazine();
 		FreeList* freeItem = r_cast<FreeList*>(addr);
-		freeItem->next = _freeList;
-		_freeList = freeItem;
+		freeItem->next = magazine.items;
+		magazine.items = freeItem;
+		magazine.count++;
+		MemoryPoolBase::countFree();
+		if (magazine.count >= BatchSize * 2)
+		{
+			// give a full batch back for other threads
+			FreeList* tail = magazine.items;
+			for (int i = 1; i < BatchSize; i++) tail = tail->next;
+			FreeList* batch = magazine.items;
+			magazine.items = tail->next;
+			tail->next = nullptr;
+			magazine.count -= BatchSize;
+			MemoryPool::pushBatch(batch);
+		}
 	}
 	template<class... Args>
 	Item* newItem(Args&&... args)
 	{
-		Item* mem = r_cast<Item*>(MemoryPool<Item, CHUNK_CAPACITY>::alloc());
+		Item* mem = r_cast<Item*>(MemoryPool::alloc());
 		return new (mem) Item(std::forward<Args>(args)...);
 	}
 	void deleteItem(Item* item)
 	{
 		item->~Item();
-		MemoryPool<Item, CHUNK_CAPACITY>::free(r_cast<void*>(item));
+		MemoryPool::free(r_cast<void*>(item));
 	}
 	int capacity()
 	{
-		int chunkCount = 0;
-		for (Chunk* chunk = _chunk; chunk; chunk = chunk->next)
-		{
-			++chunkCount;
-		}
-		return chunkCount * CHUNK_CAPACITY;
+		return MemoryPoolBase::getCapacity();
 	}
+	/** @brief Release chunks with all items free, items still cached
+	 in magazines of other threads keep their chunks alive. */
 	void shrink()
 	{
-		Chunk* prevChunk = nullptr;
-		FreeList* sortedChunkList = nullptr; // 总空闲队列
-		FreeList* sortedChunkListTail = nullptr; // 总空闲队列尾
-		FreeList* prev = nullptr; // 前一个遍历到的原回收队列的item
-		for (Chunk* chunk = _chunk->next; chunk;) // 从_chunk的next开始检测，保留根部的chunk不被释放
+		while (!MemoryPool::shrink(std::numeric_limits<int>::max()));
+	}
+	/** @brief Free items are counted into their chunks in linear time,
+	 chunks with all items free are released and the others give
+	 their items back. Allocation keeps working between the steps. */
+	virtual bool shrink(int budget) override
+	{
+		bx::MutexScope lock(_mutex);
+		while (budget > 0)
 		{
-			size_t begin = (size_t)chunk->buffer;
-			size_t end = begin + CHUNK_CAPACITY;
-			int count = 0;
-			FreeList* chunkList = nullptr; // 找到的属于当前的chunk的item队列
-			FreeList* chunkListTail = nullptr; // 当前的chunk的item队列尾
-			prev = nullptr; // 遍历的前一个item
-			for (FreeList* list = _freeList; list;) // 遍历整个回收来的item队列
+			switch (_shrinkState)
 			{
-				size_t loc = (size_t)list;
-				if (begin <= loc && loc < end) // 检查当前item是否属于当前的chunk
+				case ShrinkState::Idle:
 				{
-					++count; // 记录找到属于chunk的空闲item的数量
-					FreeList* temp = list;
-					if (prev) prev->next = list->next; // 从链表中间取出当前的item
-					else _freeList = list->next; // 从链表头部取出当前的item
-					list = list->next; // 遍历到下一个item
-					temp->next = chunkList;
-					chunkList = temp; // 将找到的item添加到当前chunk的item队列头部
-					if (!chunkListTail) chunkListTail = chunkList; // 记录尾节点
+					// take the free items as they are, batches are walked while counting
+					Magazine& magazine = MemoryPool::getMagazine();
+					_shrinkItems = magazine.items;
+					magazine.items = nullptr;
+					magazine.count = 0;
+					{
+						bx::MutexScope popLock(_popMutex);
+						_shrinkBatches = _batches.exchange(nullptr, std::memory_order_acquire);
+					}
+					_shrinkState = ShrinkState::Counting;
+					break;
 				}
-				else
+				case ShrinkState::Counting:
 				{
-					prev = list; // 记录上一个item
-					list = list->next; // 遍历到下一个item
+					if (!_shrinkItems)
+					{
+						if (!_shrinkBatches)
+						{
+							_shrinkState = ShrinkState::Releasing;
+							_shrinkPrev = _chunk;
+							MemoryPool::returnItems(_chunk);
+							break;
+						}
+						_shrinkItems = _shrinkBatches;
+						_shrinkBatches = _shrinkBatches->nextBatch;
+					}
+					FreeList* item = _shrinkItems;
+					_shrinkItems = item->next;
+					Chunk* chunk = MemoryPool::findChunk(item);
+					item->next = chunk->freeItems;
+					chunk->freeItems = item;
+					chunk->freeCount++;
+					budget--;
+					break;
 				}
-			}
-			if (count == (int)(CHUNK_CAPACITY / ITEM_SIZE)) // 发现chunk中的所有item都是空闲的
-			{
-				Chunk* temp = chunk;
-				if (prevChunk) prevChunk->next = chunk->next; // 从链表中间取出当前的chunk
-				else _chunk->next = chunk->next; // 从链表头部取出当前的chunk
-				chunk = chunk->next; // 遍历到下一个chunk
-				delete temp; // 删除当前chunk
-			}
-			else
-			{
-				if (sortedChunkListTail)
+				case ShrinkState::Releasing:
 				{
-					sortedChunkListTail->next = chunkList; // 往总空闲队列的尾部添加当前chunk的空闲队列
+					// chunks are only added to the front, so the one after the
+					// previous visited chunk is still the next to check
+					Chunk* chunk = _shrinkPrev->next;
+					if (!chunk)
+					{
+						_shrinkState = ShrinkState::Idle;
+						_shrinkPrev = nullptr;
+						return true;
+					}
+					if (chunk->size == ChunkItems * ItemSize && chunk->freeCount == ChunkItems)
+					{
+						_shrinkPrev->next = chunk->next;
+						MemoryPool::removeChunk(chunk);
+					}
+					else
+					{
+						budget -= chunk->freeCount;
+						MemoryPool::returnItems(chunk);
+						_shrinkPrev = chunk;
+					}
+					budget--;
+					break;
 				}
-				else sortedChunkList = chunkList; // 记录总空闲队列的头部
-				sortedChunkListTail = chunkListTail; // 总空闲队列的尾部设置为当前chunk空闲队列的尾部
-				prevChunk = chunk; // 记录上一个chunk
-				chunk = chunk->next; // 遍历到下一个chunk
 			}
 		}
-		if (prev) prev->next = sortedChunkList; // prev现在为原回收队列的队尾，往队尾接上总空闲队列
-		else _freeList = sortedChunkList; // 将回收队列设置为总空闲队列
+		return false;
 	}
 private:
-	struct FreeList
-	{
-		FreeList* next;
-	};
 	struct Chunk
 	{
 		Chunk(Chunk* next = nullptr) :
 			buffer(new char[CHUNK_CAPACITY]),
 			size(0),
-			next(next)
+			next(next),
+			freeItems(nullptr),
+			freeCount(0)
 		{ }
 		~Chunk() { delete [] buffer; }
 		int size;
 		char* buffer;
 		Chunk* next;
+		// free items counted into this chunk while shrinking
+		FreeList* freeItems;
+		int freeCount;
 	};
-	FreeList* _freeList;
-	Chunk* _chunk;
+	ENUM_START(ShrinkState)
+	{
+		Idle,
+		Counting,
+		Releasing
+	}
+	ENUM_END(ShrinkState)
+	void addChunk()
+	{
+		_chunk = new Chunk(_chunk);
+		// a chunk is not aligned and may cross two pages, but only one chunk starts in a page
+		_chunkPages[r_cast<uintptr_t>(_chunk->buffer) / CHUNK_CAPACITY] = _chunk;
+		_chunkCount++;
+	}
+	void removeChunk(Chunk* chunk)
+	{
+		_chunkPages.erase(r_cast<uintptr_t>(chunk->buffer) / CHUNK_CAPACITY);
+		_chunkCount--;
+		_carvedCount -= chunk->size / ItemSize;
+		delete chunk;
+	}
+	Chunk* findChunk(void* item)
+	{
+		uintptr_t address = r_cast<uintptr_t>(item);
+		uintptr_t page = address / CHUNK_CAPACITY;
+		auto it = _chunkPages.find(page);
+		if (it == _chunkPages.end() || r_cast<uintptr_t>(it->second->buffer) > address)
+		{
+			it = _chunkPages.find(page - 1);
+		}
+		return it->second;
+	}
+	void returnItems(Chunk* chunk)
+	{
+		MemoryPool::pushFreeList(chunk->freeItems);
+		chunk->freeItems = nullptr;
+		chunk->freeCount = 0;
+	}
+	Magazine& getMagazine()
+	{
+		Magazine& magazine = _magazine;
+		if (magazine.pool != this)
+		{
+			if (magazine.pool) magazine.pool->flush(magazine);
+			magazine.pool = this;
+		}
+		return magazine;
+	}
+	void refill(Magazine& magazine)
+	{
+		FreeList* batch = MemoryPool::popBatch();
+		if (batch)
+		{
+			int count = 0;
+			for (FreeList* item = batch; item; item = item->next) count++;
+			magazine.items = batch;
+			magazine.count = count;
+			return;
+		}
+		bx::MutexScope lock(_mutex);
+		for (int i = 0; i < BatchSize; i++)
+		{
+			if (_chunk->size + ItemSize > CHUNK_CAPACITY)
+			{
+				MemoryPool::addChunk();
+				int consumption = MemoryPoolBase::getCapacity();
+				if (consumption > WARNING_SIZE * 1024)
+				{
+					Log("[WARNING] MemoryPool consumes %d KB memory larger than %d KB for type %s",
+						consumption / 1024, WARNING_SIZE, MemoryPoolBase::getName().c_str());
+				}
+			}
+			FreeList* item = r_cast<FreeList*>(_chunk->buffer + _chunk->size);
+			_chunk->size += ItemSize;
+			_carvedCount++;
+			item->next = magazine.items;
+			magazine.items = item;
+			magazine.count++;
+		}
+	}
+	void flush(Magazine& magazine)
+	{
+		if (magazine.items)
+		{
+			MemoryPool::pushBatch(magazine.items);
+		}
+		magazine.items = nullptr;
+		magazine.count = 0;
+	}
+	void pushBatch(FreeList* batch)
+	{
+		batch->nextBatch = _batches.load(std::memory_order_relaxed);
+		while (!_batches.compare_exchange_weak(batch->nextBatch, batch,
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+	FreeList* popBatch()
+	{
+		// pops are serialized, so the head can only be replaced by pushes
+		// and is never popped and pushed back between the loads, no ABA problem
+		bx::MutexScope lock(_popMutex);
+		FreeList* batch = _batches.load(std::memory_order_acquire);
+		while (batch && !_batches.compare_exchange_weak(batch, batch->nextBatch,
+			std::memory_order_acquire, std::memory_order_acquire));
+		return batch;
+	}
+	void pushFreeList(FreeList* freeList)
+	{
+		while (freeList)
+		{
+			FreeList* batch = freeList;
+			FreeList* tail = batch;
+			for (int i = 1; i < BatchSize && tail->next; i++) tail = tail->next;
+			freeList = tail->next;
+			tail->next = nullptr;
+			MemoryPool::pushBatch(batch);
+		}
+	}
 	void deleteChunk(Chunk* chunk)
 	{
 		if (chunk)
@@ -165,8 +393,22 @@ private:
 			delete chunk;
 		}
 	}
+	Chunk* _chunk;
+	bx::Mutex _mutex;
+	bx::Mutex _popMutex;
+	std::atomic<FreeList*> _batches;
+	unordered_map<uintptr_t, Chunk*> _chunkPages;
+	ShrinkState _shrinkState;
+	FreeList* _shrinkItems;
+	FreeList* _shrinkBatches;
+	Chunk* _shrinkPrev;
+	static thread_local Magazine _magazine;
 };
 
+template<class Item, int CHUNK_CAPACITY, int WARNING_SIZE>
+thread_local typename MemoryPool<Item, CHUNK_CAPACITY, WARNING_SIZE>::Magazine
+	MemoryPool<Item, CHUNK_CAPACITY, WARNING_SIZE>::_magazine;
+
 #define USE_MEMORY_POOL(type) \
 public:\
 	inline void* operator new(size_t size) { return _memory.alloc(); }\
@@ -182,10 +424,29 @@ public:\
 	{\
 		return _memory.capacity();\
 	}\
+	static void poolCollectAsync()\
+	{\
+		_memory.shrinkAsync();\
+	}\
 private:\
 	static MemoryPool<type> _memory;
 
 #define MEMORY_POOL(type) \
-MemoryPool<type> type::_memory;
+MemoryPool<type> type::_memory(#type);
+
+/** @brief Pools of memory blocks in a few size classes, for small objects
+ of many types made in one thread and freed in another, like jobs and future states.
+ Sizes larger than the biggest class are allocated from the heap. */
+class BlockPool
+{
+public:
+	static void* alloc(size_t size);
+	static void free(void* addr, size_t size);
+};
+
+#define USE_BLOCK_POOL \
+public:\
+	inline void* operator new(size_t size) { return BlockPool::alloc(size); }\
+	inline void operator delete(void* ptr, size_t size) { BlockPool::free(ptr, size); }
 
 NS_DOROTHY_END
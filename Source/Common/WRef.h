@@ -10,46 +10,22 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-/** @brief Used for weak reference. */
+/** @brief Used for weak reference. Keeps the object id and the generation
+ of its slot, an object is expired when the generation of the slot changes.
+ Making a weak reference costs no allocation. */
 template<class T = Object>
 class WRef
 {
 public:
-	WRef(): _weak(nullptr)
+	WRef(): _item(nullptr), _id(0), _generation(0)
 	{ }
-	explicit WRef(T* item): _weak(nullptr)
+	explicit WRef(T* item)
 	{
-		if (item)
-		{
-			_weak = item->getWeakRef();
-			_weak->retain();
-		}
-	}
-	WRef(const Ref<T>& ref): _weak(nullptr)
-	{
-		if (ref)
-		{
-			_weak = ref->getWeakRef();
-			_weak->retain();
-		}
+		WRef::set(item);
 	}
-	WRef(const WRef& ref): _weak(ref._weak)
+	WRef(const Ref<T>& ref)
 	{
-		if (_weak)
-		{
-			_weak->retain();
-		}
-	}
-	WRef(WRef&& ref): _weak(ref._weak)
-	{
-		ref._weak = nullptr;
-	}
-	~WRef()
-	{
-		if (_weak)
-		{
-			_weak->release();
-		}
+		WRef::set(ref.get());
 	}
 	inline T* operator->() const
 	{
@@ -57,41 +33,12 @@ public:
 	}
 	T* operator=(T* item)
 	{
-		Weak* weak = nullptr;
-		if (item)
-		{
-			weak = item->getWeakRef();
-			weak->retain();
-		}
-		if (_weak)
-		{
-			_weak->release();
-		}
-		_weak = weak;
+		WRef::set(item);
 		return item;
 	}
 	const WRef& operator=(const Ref<T>& ref)
 	{
-		operator=(ref.get());
-		return *this;
-	}
-	const WRef& operator=(const WRef& ref)
-	{
-		operator=(ref.get());
-		return *this;
-	}
-	const WRef& operator=(WRef&& ref)
-	{
-		if (this == &ref)
-		{
-			return *this;
-		}
-		if (_weak)
-		{
-			_weak->release();
-		}
-		_weak = ref._weak;
-		ref._weak = nullptr;
+		WRef::set(ref.get());
 		return *this;
 	}
 	bool operator==(const WRef& ref) const
@@ -116,11 +63,27 @@ public:
 	}
 	inline T* get() const
 	{
-		if (_weak) return s_cast<T*>(_weak->target);
-		else return nullptr;
+		// slot 0 is never used, so an empty weak ref gets nullptr too
+		return Object::_slots[_id].generation == _generation ? _item : nullptr;
 	}
 private:
-	Weak* _weak;
+	void set(T* item)
+	{
+		_item = item;
+		if (item)
+		{
+			_id = item->getId();
+			_generation = Object::_slots[_id].generation;
+		}
+		else
+		{
+			_id = 0;
+			_generation = 0;
+		}
+	}
+	T* _item;
+	Uint32 _id;
+	Uint32 _generation;
 };
 
 template <class name>
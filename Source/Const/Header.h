@@ -21,6 +21,7 @@ using std::stack;
 #include <unordered_set>
 using std::unordered_set;
 #include <memory>
+#include <atomic>
 #include <sstream>
 using std::ostringstream;
 #include <tuple>
@@ -36,6 +37,7 @@ using Acf::Delegate;
 #include "bgfx/bgfx.h"
 #include "bx/thread.h"
 #include "bx/sem.h"
+#include "bx/mutex.h"
 #include "silly/LifeCycledSingleton.h"
 #include "silly/Slice.h"
 using namespace silly::slice;
@@ -51,13 +53,20 @@ using namespace Dorothy::Switch::Literals;
 #include "Common/WRef.h"
 #include "Common/WRefVector.h"
 #include "Common/Debug.h"
+#include "Common/MemoryPool.h"
+#include "Common/FrameArena.h"
 #include "Basic/AutoreleasePool.h"
 #include "Basic/Content.h"
+#include "Basic/Pack.h"
 #include "Lua/LuaEngine.h"
+#include "Common/Atom.h"
 #include "Event/Event.h"
 #include "Event/Listener.h"
 #include "Event/EventQueue.h"
 #include "Basic/Application.h"
 #include "Basic/Director.h"
+#include "Basic/TimerWheel.h"
 #include "Basic/Scheduler.h"
+#include "Common/JobSystem.h"
+#include "Common/Future.h"
 #include "Common/Async.h"
@@ -13,64 +13,79 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-unordered_map<string, Own<EventType>> Event::_eventMap;
+vector<Own<EventType>> Event::_eventTypes;
 
-Event::Event()
+Event::Event():
+_id(0)
 {}
 
 Event::Event(String name):
-_name(name)
+_id(Atom::intern(name))
 { }
 
+Event::Event(Uint32 id):
+_id(id)
+{ }
+
+const string& Event::getName() const
+{
+	return Atom::getName(_id);
+}
+
 Event::~Event()
 { }
 
 void Event::clear()
 {
-	_eventMap.clear();
+	_eventTypes.clear();
 }
 
 void Event::unreg(Listener* listener)
 {
-	auto it = _eventMap.find(listener->getName());
-	if (it != _eventMap.end())
+	Uint32 id = listener->getId();
+	if (id < _eventTypes.size() && _eventTypes[id])
 	{
-		EventType* type = it->second;
+		EventType* type = _eventTypes[id];
 		type->remove(listener);
 		if (type->isEmpty())
 		{
-			_eventMap.erase(it);
+			_eventTypes[id] = nullptr;
 		}
 	}
 }
 
 void Event::reg(Listener* listener)
 {
-	auto it = _eventMap.find(listener->getName());
-	if (it != _eventMap.end())
+	Uint32 id = listener->getId();
+	if (id >= _eventTypes.size())
 	{
-		it->second->add(listener);
+		_eventTypes.resize(id + 1);
 	}
-	else
+	if (!_eventTypes[id])
 	{
-		EventType* type = new EventType(listener->getName());
-		_eventMap[listener->getName()] = OwnMake(type);
-		type->add(listener);
+		_eventTypes[id] = OwnNew<EventType>(id);
 	}
+	_eventTypes[id]->add(listener);
 }
 
 void Event::send(Event* e)
 {
-	auto it = _eventMap.find(e->getName());
-	if (it != _eventMap.end())
+	Uint32 id = e->getId();
+	if (id < _eventTypes.size() && _eventTypes[id])
 	{
-		it->second->handle(e);
+		_eventTypes[id]->handle(e);
 	}
 }
 
 Listener* Event::addListener(String name, const EventHandler& handler)
 {
-	Listener* listener = Listener::create(name, handler);
+	Listener* listener = Listener::create(Atom::intern(name), handler);
+	return listener;
+}
+
+Listener* Event::addListener(Uint32 id, const EventHandler& handler)
+{
+	Listener* listener = Listener::create(id, handler);
 	return listener;
 }
 
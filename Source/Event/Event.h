@@ -29,7 +29,10 @@ typedef Delegate<void (Event* event)> EventHandler;
 
  // Send event with all types of arguments, then the callback function will be invoked.
  Event::send("UserEvent", Slice("info1"));
- Event::send("UserEvent", Slice("msg2"));
+
+ // Send event by an interned name id to skip the name lookup.
+ static const Uint32 UserEvent = Atom::intern("UserEvent");
+ Event::send(UserEvent, Slice("msg2"));
  */
 class Event
 {
@@ -37,24 +40,32 @@ public:
 	Event();
 	virtual ~Event();
 	Event(String name);
-	inline const string& getName() const { return _name; }
+	Event(Uint32 id);
+	/** @brief Interned id of the event name. */
+	inline Uint32 getId() const { return _id; }
+	const string& getName() const;
 	virtual int pushArgsToLua() { return 0; }
 public:
 	static Listener* addListener(String name, const EventHandler& handler);
+	static Listener* addListener(Uint32 id, const EventHandler& handler);
 	static void clear();
 
 	template<class... Args>
 	static void send(String name, Args&&... args);
 
+	template<class... Args>
+	static void send(Uint32 id, Args&&... args);
+
 	template<class... Args>
 	static void retrieve(Event* event, Args&... args);
 private:
 	static void reg(Listener* listener);
 	static void unreg(Listener* listener);
-	static unordered_map<string, Own<EventType>> _eventMap;
+	// indexed by interned ids of event names
+	static vector<Own<EventType>> _eventTypes;
 protected:
 	static void send(Event* event);
-	string _name;
+	Uint32 _id;
 	friend class Listener;
 };
 
@@ -63,9 +74,9 @@ class EventArgs : public Event
 {
 public:
 	template<class... Args>
-	static void send(String name, Args&&... args)
+	static void send(Uint32 id, Args&&... args)
 	{
-		_event._name = name;
+		_event._id = id;
 		_event.arguments = std::make_tuple(args...);
 		Event::send(&_event);
 	}
@@ -93,7 +104,13 @@ EventArgs<Fields...> EventArgs<Fields...>::_event;
 template<class... Args>
 void Event::send(String name, Args&&... args)
 {
-	EventArgs<Args...>::send(name, args...);
+	EventArgs<Args...>::send(Atom::intern(name), args...);
+}
+
+template<class... Args>
+void Event::send(Uint32 id, Args&&... args)
+{
+	EventArgs<Args...>::send(id, args...);
 }
 
 template<class... Args>
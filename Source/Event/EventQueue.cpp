@@ -11,26 +11,114 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-QEvent::QEvent(String name):
-_name(name)
+QEvent::QEvent(Uint32 id):
+_id(id)
 { }
 
+const string& QEvent::getName() const
+{
+	return Atom::getName(_id);
+}
+
 QEvent::~QEvent()
 { }
 
+QMessage::QMessage()
+{
+	_slot.id = 0;
+	_slot.size = 0;
+}
+
+QMessage::~QMessage()
+{
+	QMessage::clear();
+}
+
+Uint32 QMessage::getId() const
+{
+	return _slot.id;
+}
+
+QEvent* QMessage::getEvent() const
+{
+	return _slot.size == QSlot::Boxed ? _slot.event : nullptr;
+}
+
+void QMessage::clear()
+{
+	if (_slot.size == QSlot::Boxed)
+	{
+		delete _slot.event;
+	}
+	_slot.id = 0;
+	_slot.size = 0;
+}
+
+EventQueue::EventQueue(Uint32 capacity):
+_head(0),
+_tail(0),
+_overflowCount(0)
+{
+	Uint32 size = 1;
+	while (size < capacity) size <<= 1;
+	_mask = size - 1;
+	_buffer = OwnArray<Uint8>(new Uint8[QSlot::Size * (size + 1)]);
+	uintptr_t address = r_cast<uintptr_t>(_buffer.get());
+	address = (address + QSlot::Size - 1) & ~uintptr_t(QSlot::Size - 1);
+	_slots = r_cast<QSlot*>(address);
+}
+
 EventQueue::~EventQueue()
 {
-	for (QEvent* e = poll(); e; e = poll());
+	QMessage message;
+	while (EventQueue::poll(message));
+}
+
+void EventQueue::post(Uint32 id)
+{
+	QSlot slot;
+	slot.id = id;
+	slot.size = 0;
+	EventQueue::push(slot);
 }
 
-Own<QEvent> EventQueue::poll()
+void EventQueue::push(const QSlot& slot)
 {
-	return OwnMake(_queue.pop());
+	Uint32 tail = _tail.load(std::memory_order_relaxed);
+	if (_overflowCount == 0 && tail - _head.load(std::memory_order_acquire) <= _mask)
+	{
+		_slots[tail & _mask] = slot;
+		_tail.store(tail + 1, std::memory_order_release);
+	}
+	else
+	{
+		// ring buffer is full, spill messages until the consumer catches up
+		++_overflowCount;
+		_overflow.push(new QSlot(slot));
+	}
 }
 
-QEvent* EventQueue::peek()
+bool EventQueue::poll(QMessage& message)
 {
-	return _queue.peek();
+	message.clear();
+	// spilled messages are newer than everything in the ring buffer,
+	// check for them before checking the ring buffer is drained
+	bool overflow = _overflowCount > 0;
+	Uint32 head = _head.load(std::memory_order_relaxed);
+	if (head != _tail.load(std::memory_order_acquire))
+	{
+		message._slot = _slots[head & _mask];
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	Own<QSlot> slot(overflow ? _overflow.pop() : nullptr);
+	if (slot)
+	{
+		message._slot = *slot;
+		--_overflowCount;
+		return true;
+	}
+	return false;
 }
 
 NS_DOROTHY_END
@@ -15,11 +15,13 @@ NS_DOROTHY_BEGIN
 class QEvent
 {
 public:
-	QEvent(String name);
+	QEvent(Uint32 id);
 	virtual ~QEvent();
-	inline const string& getName() const { return _name; }
+	/** @brief Interned id of the event name. */
+	inline Uint32 getId() const { return _id; }
+	const string& getName() const;
 protected:
-	string _name;
+	Uint32 _id;
 };
 
 template<class... Fields>
@@ -27,31 +29,147 @@ class QEventArgs : public QEvent
 {
 public:
 	template<class... Args>
-	QEventArgs(String name, Args&&... args):
-	QEvent(name),
+	QEventArgs(Uint32 id, Args&&... args):
+	QEvent(id),
 	arguments(std::make_tuple(args...))
 	{ }
 	std::tuple<Fields...> arguments;
 };
 
+/** @brief Fixed size slot in the ring buffer of an event queue.
+ Trivially copyable payloads that fit are copied inline,
+ others are boxed in a heap allocated event. */
+struct QSlot
+{
+	enum
+	{
+		Size = 64,
+		PayloadSize = Size - sizeof(Uint32) * 2,
+		Boxed = 0xffffffff
+	};
+	Uint32 id;
+	Uint32 size;
+	union
+	{
+		Uint8 data[PayloadSize];
+		QEvent* event;
+	};
+};
+
+static_assert(sizeof(QSlot) == QSlot::Size, "event queue slot must fill a cache line.");
+
+/** @brief A message taken from an event queue, owns its boxed event. */
+class QMessage
+{
+public:
+	QMessage();
+	~QMessage();
+	/** @brief Integer id of the message, 0 for events posted by name. */
+	PROPERTY_READONLY(Uint32, Id);
+	/** @brief The boxed event for named or large messages, nullptr otherwise. */
+	PROPERTY_READONLY(QEvent*, Event);
+	template<class T>
+	void retrieve(T& value) const
+	{
+		if (_slot.size == QSlot::Boxed)
+		{
+			auto targetEvent = d_cast<QEventArgs<T>*>(_slot.event);
+			AssertIf(targetEvent == nullptr, "no required event argument type can be retrieved.");
+			value = std::get<0>(targetEvent->arguments);
+		}
+		else
+		{
+			AssertUnless(_slot.size == sizeof(T), "no required message payload type can be retrieved.");
+			std::memcpy(&value, _slot.data, sizeof(T));
+		}
+	}
+	void clear();
+private:
+	QMessage(const QMessage&);
+	const QMessage& operator=(const QMessage&);
+	QSlot _slot;
+	friend class EventQueue;
+};
+
+/** @brief Single producer and single consumer event queue.
+ Messages are passed through a bounded ring buffer of cache line sized slots,
+ the queue only allocates for boxed payloads or when the ring buffer is full.
+ @example Use it as below.
+
+ // producer thread
+ queue.post(MessageId, sdlEvent);
+ queue.post("Named", string("args"), 1);
+
+ // consumer thread
+ QMessage message;
+ while (queue.poll(message))
+ {
+ 	switch (message.getId())
+ 	{
+ 		case MessageId:
+ 		{
+ 			SDL_Event sdlEvent;
+ 			message.retrieve(sdlEvent);
+ 			break;
+ 		}
+ 		case 0:
+ 		{
+ 			string str; int num;
+ 			EventQueue::retrieve(message.getEvent(), str, num);
+ 			break;
+ 		}
+ 	}
+ }
+ */
 class EventQueue
 {
 public:
+	/** @param capacity slot count of the ring buffer, rounded up to power of two. */
+	EventQueue(Uint32 capacity = 256);
 	~EventQueue();
 
-	/** @brief Post a new event,
+	/** @brief Post a message with an integer id and a trivially copyable payload,
 	 for producer thread use only. */
+	template<class T>
+	void post(Uint32 id, const T& payload)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "message payload must be trivially copyable.");
+		QSlot slot;
+		slot.id = id;
+		if (sizeof(T) <= QSlot::PayloadSize)
+		{
+			slot.size = sizeof(T);
+			std::memcpy(slot.data, &payload, sizeof(T));
+		}
+		else
+		{
+			slot.size = QSlot::Boxed;
+			slot.event = new QEventArgs<T>(0, payload);
+		}
+		EventQueue::push(slot);
+	}
+
+	/** @brief Post a message with only an integer id,
+	 for producer thread use only. */
+	void post(Uint32 id);
+
+	/** @brief Post a new event with a name and any arguments,
+	 the event is boxed and received with message id 0,
+	 check the interned name id of the boxed event instead.
+	 For producer thread use only. */
 	template<class... Args>
 	void post(String name, const Args& ...args)
 	{
-		auto event = new QEventArgs<Args...>(name, args...);
-		_queue.push(event);
+		QSlot slot;
+		slot.id = 0;
+		slot.size = QSlot::Boxed;
+		slot.event = new QEventArgs<Args...>(Atom::intern(name), args...);
+		EventQueue::push(slot);
 	}
 
-	/** @brief Try get a posted event,
+	/** @brief Try get a posted message,
 	 for consumer thread use only. */
-	Own<QEvent> poll();
-	QEvent* peek();
+	bool poll(QMessage& message);
 
 	template<class... Args>
 	static void retrieve(QEvent* event, Args&... args)
@@ -61,7 +179,18 @@ public:
 		std::tie(args...) = targetEvent->arguments;
 	}
 private:
-	bx::SpScUnboundedQueue<QEvent> _queue;
+	void push(const QSlot& slot);
+	Uint32 _mask;
+	QSlot* _slots;
+	OwnArray<Uint8> _buffer;
+	// keep the indices written by different threads in different cache lines
+	Uint8 _padding0[QSlot::Size];
+	std::atomic<Uint32> _head;
+	Uint8 _padding1[QSlot::Size];
+	std::atomic<Uint32> _tail;
+	Uint8 _padding2[QSlot::Size];
+	std::atomic<Uint32> _overflowCount;
+	bx::SpScUnboundedQueue<QSlot> _overflow;
 };
 
 NS_DOROTHY_END
@@ -13,13 +13,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 NS_DOROTHY_BEGIN
 
-EventType::EventType(const string& name):
-_name(name)
+EventType::EventType(Uint32 id):
+_id(id)
 { }
 
 const string& EventType::getName() const
 {
-	return _name;
+	return Atom::getName(_id);
 }
 
 void EventType::add(Listener* listener)
@@ -17,14 +17,15 @@ class Listener;
 class EventType
 {
 public:
-	EventType(const string& name);
+	EventType(Uint32 id);
+	inline Uint32 getId() const { return _id; }
 	const string& getName() const;
 	void add(Listener* listener);
 	void remove(Listener* listener);
 	void handle(Event* event);
 	bool isEmpty() const;
 protected:
-	string _name;
+	Uint32 _id;
 private:
 	void handle(Event* event, int index);
 	vector<Listener*> _listeners;
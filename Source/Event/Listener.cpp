@@ -58,15 +58,20 @@ void Listener::handle( Event* e )
 	}
 }
 
-Listener::Listener( const string& name, const EventHandler& handler ):
-_name(name),
+Listener::Listener( Uint32 id, const EventHandler& handler ):
+_id(id),
 _handler(handler),
 _enabled(false)
 { }
 
+Uint32 Listener::getId() const
+{
+	return _id;
+}
+
 const string& Listener::getName() const
 {
-	return _name;
+	return Atom::getName(_id);
 }
 
 Listener::~Listener()
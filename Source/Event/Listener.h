@@ -21,6 +21,8 @@ class Listener : public Object
 public:
 	virtual ~Listener();
 	virtual bool init() override;
+	/** Interned id of the event name. */
+	Uint32 getId() const;
 	const string& getName() const;
 	/** True to receive event and handle it, false to not receive event. */
 	void setEnabled(bool enable);
@@ -36,10 +38,10 @@ public:
 	/** Use it to create a new listener. You may want to get the listener retained for future use. */
 	CREATE_FUNC(Listener);
 protected:
-	Listener(const string& name, const EventHandler& handler);
-	Listener(const string& name, int handler);
+	Listener(Uint32 id, const EventHandler& handler);
+	Listener(Uint32 id, int handler);
 	bool _enabled;
-	string _name;
+	Uint32 _id;
 	EventHandler _handler;
 	friend class EventType;
 	LUA_TYPE_OVERRIDE(Listener)
@@ -13,6 +13,39 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 NS_DOROTHY_BEGIN
 
 int LuaEngine::_callFromLua = 0;
+bool LuaEngine::_bytecodeCache = true;
+
+// cached bytecode is valid for the same source and the same build of the engine
+struct BytecodeHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint64 sourceSize;
+	Uint64 sourceHash;
+};
+static const char BytecodeMagic[4] = {'D', 'L', 'B', 'C'};
+static const Uint32 BytecodeVersion = 1 | (sizeof(void*) << 16);
+static const char* BytecodeFolder = "LuaCache/";
+
+static Uint64 dora_hash(const char* data, size_t size)
+{
+	// FNV-1a
+	Uint64 hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= s_cast<Uint8>(data[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static int dora_writer(lua_State* L, const void* data, size_t size, void* buffer)
+{
+	DORA_UNUSED_PARAM(L);
+	const Uint8* bytes = s_cast<const Uint8*>(data);
+	s_cast<vector<Uint8>*>(buffer)->insert(s_cast<vector<Uint8>*>(buffer)->end(), bytes, bytes + size);
+	return 0;
+}
 
 static int dora_print(lua_State* L)
 {
@@ -54,6 +87,49 @@ static int dora_traceback(lua_State* L)
 	return 0;
 }
 
+struct ModuleFile
+{
+	string file;
+	string extension;
+};
+
+// files resolved for names without extension, an empty file for a name not found
+static unordered_map<string, ModuleFile>& getModuleFiles()
+{
+	static unordered_map<string, ModuleFile> files;
+	return files;
+}
+
+static const ModuleFile& dora_resolvefile(const string& filename)
+{
+	// resolved files are kept until the paths of Content change
+	static Uint32 pathVersion = 0;
+	unordered_map<string, ModuleFile>& files = getModuleFiles();
+	Uint32 version = SharedContent.getPathVersion();
+	if (pathVersion != version)
+	{
+		files.clear();
+		pathVersion = version;
+	}
+	auto it = files.find(filename);
+	if (it != files.end())
+	{
+		return it->second;
+	}
+	ModuleFile& module = files[filename];
+	if (SharedContent.hasFile(filename + ".lua"))
+	{
+		module.file = filename + ".lua";
+		module.extension = "lua";
+	}
+	else if (SharedContent.hasFile(filename + ".xml"))
+	{
+		module.file = filename + ".xml";
+		module.extension = "xml";
+	}
+	return module;
+}
+
 static int dora_loadfile(lua_State* L, String filename)
 {
 	AssertIf(filename.empty(), "passing empty filename string to lua loader.");
@@ -61,28 +137,19 @@ static int dora_loadfile(lua_State* L, String filename)
 	string targetFile = filename;
 	if (extension.empty() && targetFile.back() != '.')
 	{
-		if (SharedContent.isFileExist(targetFile + ".lua"))
+		const ModuleFile& module = dora_resolvefile(targetFile);
+		if (module.file.empty())
 		{
-			targetFile.append(".lua");
-		}
-		else
-		{
-			if (SharedContent.isFileExist(targetFile + ".xml"))
-			{
-				targetFile.append(".xml");
-				extension = "xml";
-			}
-			else
-			{
-				lua_pushnil(L);
-				lua_pushfstring(L, "xml or lua file not found for filename \"%s\"", filename.toString().c_str());
-				return 2;
-			}
+			lua_pushnil(L);
+			lua_pushfstring(L, "xml or lua file not found for filename \"%s\"", filename.toString().c_str());
+			return 2;
 		}
+		targetFile = module.file;
+		extension = module.extension;
 	}
 
 	Sint64 codeBufferSize = 0;
-	OwnArray<Uint8> buffer;
+	Ref<FileView> view;
 	const char* codeBuffer = nullptr;
 	string codes;
 	switch (Switch::hash(extension))
@@ -100,14 +167,18 @@ static int dora_loadfile(lua_State* L, String filename)
 			}
 			break;
 		default:
-			buffer = SharedContent.loadFile(targetFile, codeBufferSize);
-			codeBuffer = r_cast<char*>(buffer.get());
+			view = SharedContent.mapFile(targetFile);
+			if (view)
+			{
+				codeBuffer = view->rawData();
+				codeBufferSize = view->size();
+			}
 			break;
 	}
 
 	if (codeBuffer)
 	{
-		if (luaL_loadbuffer(L, codeBuffer, (size_t)codeBufferSize, filename.toString().c_str()) != 0)
+		if (LuaEngine::loadBuffer(L, codeBuffer, (size_t)codeBufferSize, targetFile, filename.toString().c_str()) != 0)
 		{
 			luaL_error(L, "error loading module \"%s\" from file \"%s\" :\n\t%s",
 				lua_tostring(L, 1), filename.toString().c_str(), lua_tostring(L, -1));
@@ -221,6 +292,95 @@ lua_State* LuaEngine::getState() const
 	return L;
 }
 
+void LuaEngine::setBytecodeCache(bool var)
+{
+	_bytecodeCache = var;
+}
+
+bool LuaEngine::isBytecodeCache() const
+{
+	return _bytecodeCache;
+}
+
+// the cache file is opened once without the path cache, stale is set for a cache of a changed source
+static bool dora_loadcache(lua_State* L, const string& cacheFile, const BytecodeHeader& header, const char* chunkName, bool& stale)
+{
+	FILE* fp = fopen(cacheFile.c_str(), "rb");
+	if (!fp)
+	{
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	long fileSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	bool loaded = false;
+	BytecodeHeader cacheHeader;
+	if (fileSize > s_cast<long>(sizeof(BytecodeHeader)) &&
+		fread(&cacheHeader, sizeof(BytecodeHeader), 1, fp) == 1 &&
+		memcmp(&cacheHeader, &header, sizeof(BytecodeHeader)) == 0)
+	{
+		vector<char> buffer(fileSize - sizeof(BytecodeHeader));
+		if (fread(buffer.data(), 1, buffer.size(), fp) == buffer.size())
+		{
+			loaded = luaL_loadbuffer(L, buffer.data(), buffer.size(), chunkName) == 0;
+			// bytecode from other builds of LuaJIT is compiled again
+			if (!loaded) lua_pop(L, 1);
+		}
+	}
+	fclose(fp);
+	stale = !loaded;
+	return loaded;
+}
+
+int LuaEngine::loadBuffer(lua_State* L, const char* codes, size_t size, String filename, const char* chunkName)
+{
+	// precompiled chunks start with an escape char and are loaded as they are
+	if (!_bytecodeCache || size == 0 || codes[0] == LUA_SIGNATURE[0])
+	{
+		return luaL_loadbuffer(L, codes, size, chunkName);
+	}
+	BytecodeHeader header;
+	memcpy(header.magic, BytecodeMagic, sizeof(header.magic));
+	header.version = BytecodeVersion;
+	header.sourceSize = size;
+	header.sourceHash = dora_hash(codes, size);
+	string fullPath = SharedContent.getFullPath(filename);
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", s_cast<unsigned long long>(dora_hash(fullPath.c_str(), fullPath.size())));
+	string cacheFolder = SharedContent.getWritablePath() + BytecodeFolder;
+	string cacheFile = cacheFolder + name;
+
+	bool stale = false;
+	if (dora_loadcache(L, cacheFile, header, chunkName, stale))
+	{
+		return 0;
+	}
+
+	int result = luaL_loadbuffer(L, codes, size, chunkName);
+	if (result == 0)
+	{
+		vector<Uint8> buffer(r_cast<Uint8*>(&header), r_cast<Uint8*>(&header) + sizeof(BytecodeHeader));
+		if (lua_dump(L, dora_writer, &buffer) == 0)
+		{
+			static bool folderReady = false;
+			if (!folderReady)
+			{
+				folderReady = SharedContent.isFolder(cacheFolder) || SharedContent.createFolder(cacheFolder);
+			}
+			Uint8* data = new Uint8[buffer.size()];
+			memcpy(data, buffer.data(), buffer.size());
+			// saved through a temp file, only the path of the cache file is invalidated
+			SharedContent.saveToFileAsync(cacheFile, OwnArray<Uint8>(data), s_cast<Sint64>(buffer.size()), []() { });
+			return result;
+		}
+	}
+	if (stale)
+	{
+		SharedContent.removeFile(cacheFile);
+	}
+	return result;
+}
+
 LuaEngine::LuaEngine()
 {
 	L = luaL_newstate();
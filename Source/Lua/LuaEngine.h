@@ -17,6 +17,9 @@ class LuaEngine : public Object
 {
 public:
 	PROPERTY_READONLY(lua_State*, State);
+	/** @brief Keep compiled chunks of loaded scripts under the writable path,
+	 they are loaded instead of the sources until the sources change. */
+	PROPERTY_BOOL_NAME(BytecodeCache);
 
 	void addLuaLoader(lua_CFunction func);
 
@@ -46,9 +49,13 @@ public:
 	static int execute(lua_State* L, int handler, int numArgs);
 	static int execute(lua_State* L, int numArgs);
 	static int invoke(lua_State* L, int handler, int numArgs, int numRets);
+	/** @brief Load a chunk of the source file from its cached bytecode
+	 when the source is unchanged, otherwise compile and cache it. */
+	static int loadBuffer(lua_State* L, const char* codes, size_t size, String filename, const char* chunkName);
 protected:
 	LuaEngine();
 	static int _callFromLua;
+	static bool _bytecodeCache;
 	lua_State* L;
 };
 
@@ -14,15 +14,14 @@ NS_DOROTHY_BEGIN
 
 void __Content_loadFile(lua_State* L, Content* self, const char* filename)
 {
-	Sint64 size = 0;
-	OwnArray<Uint8> data = self->loadFile(filename, size);
-	if (!data)
+	Ref<FileView> view = self->mapFile(filename);
+	if (!view)
 	{
 		lua_pushnil(L);
 	}
 	else
 	{
-		lua_pushlstring(L, r_cast<char*>(data.get()), (size_t)size);
+		lua_pushlstring(L, view->rawData(), view->size());
 	}
 }
 
@@ -46,6 +46,8 @@ NS_DOROTHY_BEGIN
 #define MT_DIV 10
 #define MT_LT 11
 #define MT_LE 12
+#define MT_CACHE 13
+#define MT_CACHE_GET 14
 
 #define TOLUA_UBOX 1
 #define TOLUA_CALLBACK 2
@@ -101,6 +101,92 @@ static int module_newindex_event(lua_State* L)
 	return 0;
 }
 
+/* Flattened member lookup
+	* Each class metatable keeps a table of members found through its
+	* metatable chain, with getters kept in another table and members not
+	* found marked, so an access costs one lookup instead of a chain walk.
+	* Only string keys are marked as missing, so the tables stay bounded.
+	* Members of the class itself are read directly and never cached.
+	* The tables of classes inheriting a changed class are dropped and built again lazily,
+	* but overriding an existing member of a base class is a plain table set,
+	* call tolua.classchanged(Base) after it.
+	*/
+static char class_cache_key;
+static char class_cache_miss;
+static char class_cache_getter;
+
+void tolua_classchanged(lua_State* L, int lo)
+{
+	if (lo < 0)
+	{
+		lo = lua_gettop(L) + lo + 1;
+	}
+	lua_pushlightuserdata(L, &class_cache_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);// caches
+	if (!lua_istable(L, -1))
+	{
+		lua_pop(L, 1);
+		return;
+	}
+	lua_pushnil(L);// caches nil
+	while (lua_next(L, -2) != 0)// caches mt true
+	{
+		lua_pop(L, 1);// caches mt
+		/* find the changed table in the metatable chain */
+		int affected = lo == 0;
+		lua_pushvalue(L, -1);// caches mt mt
+		while (!affected)
+		{
+			if (lua_rawequal(L, -1, lo)) affected = 1;
+			else if (lua_getmetatable(L, -1)) lua_remove(L, -2);// caches mt basemt
+			else break;
+		}
+		lua_pop(L, 1);// caches mt
+		if (affected)
+		{
+			lua_pushnil(L);// caches mt nil
+			lua_rawseti(L, -2, MT_CACHE);// mt[MT_CACHE] = nil, caches mt
+			lua_pushnil(L);// caches mt nil
+			lua_rawseti(L, -2, MT_CACHE_GET);// mt[MT_CACHE_GET] = nil, caches mt
+			lua_pushvalue(L, -1);// caches mt mt
+			lua_pushnil(L);// caches mt mt nil
+			lua_rawset(L, -4);// caches[mt] = nil, caches mt
+		}
+	}
+	lua_pop(L, 1);
+}
+
+/* push the member cache of the metatable at index mt */
+static void class_pushcache(lua_State* L, int mt)
+{
+	lua_rawgeti(L, mt, MT_CACHE);// cache
+	if (lua_istable(L, -1))
+	{
+		return;
+	}
+	lua_pop(L, 1);
+	/* remember the metatable to drop its cache */
+	lua_pushlightuserdata(L, &class_cache_key);
+	lua_rawget(L, LUA_REGISTRYINDEX);// caches
+	if (!lua_istable(L, -1))
+	{
+		lua_pop(L, 1);
+		lua_newtable(L);// caches
+		lua_pushlightuserdata(L, &class_cache_key);// caches key
+		lua_pushvalue(L, -2);// caches key caches
+		lua_rawset(L, LUA_REGISTRYINDEX);// reg[key] = caches, caches
+	}
+	lua_pushvalue(L, mt);// caches mt
+	lua_pushboolean(L, 1);// caches mt true
+	lua_rawset(L, -3);// caches[mt] = true, caches
+	lua_pop(L, 1);
+	lua_newtable(L);// tget
+	lua_rawseti(L, mt, MT_CACHE_GET);// mt[MT_CACHE_GET] = tget
+	lua_newtable(L);// cache
+	lua_pushvalue(L, -1);// cache cache
+	lua_rawseti(L, mt, MT_CACHE);// mt[MT_CACHE] = cache, cache
+}
+
 /* Class index function
 	* If the object is a userdata(ie, an object), it searches the field in
 	* the alternative table stored in the corresponding "ubox" table.
@@ -125,22 +211,63 @@ static int class_index_event(lua_State* L)
 		lua_settop(L, 2);// ud key
 		lua_getmetatable(L, 1);// ud key mt
 		/* 1 ud, 2 key, 3 mt */
+		/* members of the own metatable take one lookup without the cache */
+		lua_pushvalue(L, 2);// ud key mt key
+		lua_rawget(L, 3);// mt[key], ud key mt value
+		if (!lua_isnil(L, -1))
+		{
+			return 1;
+		}
+		lua_pop(L, 1);// ud key mt
+		/* nil and NaN can not be table keys */
+		int cacheable = !lua_isnil(L, 2) && lua_rawequal(L, 2, 2);
+		if (cacheable)
+		{
+			class_pushcache(L, 3);// ud key mt cache
+			lua_pushvalue(L, 2);// ud key mt cache key
+			lua_rawget(L, 4);// cache[key], ud key mt cache value
+			if (!lua_isnil(L, -1))
+			{
+				void* mark = lua_touserdata(L, -1);
+				if (mark == &class_cache_miss)
+				{
+					lua_pushnil(L);
+				}
+				else if (mark == &class_cache_getter)
+				{
+					lua_rawgeti(L, 3, MT_CACHE_GET);// ud key mt cache mark tget
+					lua_pushvalue(L, 2);// ud key mt cache mark tget key
+					lua_rawget(L, -2);// tget[key], ud key mt cache mark tget cfunc
+					lua_pushvalue(L, 1);// cfunc ud
+					lua_call(L, 1, 1);// return cfunc(ud)
+				}
+				return 1;
+			}
+			lua_settop(L, 3);// ud key mt
+		}
 		/* try metatables */
 		lua_pushvalue(L, 1);// ud key mt ud
-		int loop = 0;
+		int level = 0;
 		while (lua_getmetatable(L, -1))
 		{
 			/* ud key mt ud mt */
 			lua_remove(L, -2);// ud key mt mt
-			lua_pushvalue(L, 2);// ud key mt mt key
-			lua_rawget(L, -2);// mt[key], ud key mt mt value
+			/* the own metatable is already checked */
+			if (level++ == 0) lua_pushnil(L);// ud key mt mt nil
+			else
+			{
+				lua_pushvalue(L, 2);// ud key mt mt key
+				lua_rawget(L, -2);// mt[key], ud key mt mt value
+			}
 			if (!lua_isnil(L, -1))
 			{
-				if (loop)
+				if (cacheable)
 				{
-					lua_pushvalue(L, 2); // ud key mt mt value key
-					lua_pushvalue(L, -2); // ud key mt mt value key value
-					lua_rawset(L, 3); // mt[key] = value, ud key mt mt value
+					lua_rawgeti(L, 3, MT_CACHE);// ud key mt mt value cache
+					lua_pushvalue(L, 2);// ud key mt mt value cache key
+					lua_pushvalue(L, -3);// ud key mt mt value cache key value
+					lua_rawset(L, -3);// cache[key] = value, ud key mt mt value cache
+					lua_pop(L, 1);// ud key mt mt value
 				}
 				return 1;
 			}
@@ -153,20 +280,18 @@ static int class_index_event(lua_State* L)
 				lua_rawget(L, -2);// mt[key], ud key mt mt cfunc
 				if (lua_isfunction(L, -1))// check cfunc
 				{
-					if (loop)// is accessing base class
+					if (cacheable)
 					{
-						lua_rawgeti(L, 3, MT_GET); // cfunc tget
-						if (lua_isnil(L, -1)) // tget == nil
-						{
-							lua_pop(L, 1); // cfunc
-							lua_newtable(L); // cfunc tb
-							lua_pushvalue(L, -1); // cfunc tb tb
-							lua_rawseti(L, 3, MT_GET); // mt[MT_GET] = tb, cfunc tb
-						}
-						lua_pushvalue(L, 2); // cfunc tget key
-						lua_pushvalue(L, -3); // cfunc tget key cfunc
-						lua_rawset(L, -3); // tget[key] = cfunc, cfunc tget
-						lua_pop(L, 1); // cfunc
+						lua_rawgeti(L, 3, MT_CACHE_GET);// cfunc tget
+						lua_pushvalue(L, 2);// cfunc tget key
+						lua_pushvalue(L, -3);// cfunc tget key cfunc
+						lua_rawset(L, -3);// tget[key] = cfunc, cfunc tget
+						lua_pop(L, 1);// cfunc
+						lua_rawgeti(L, 3, MT_CACHE);// cfunc cache
+						lua_pushvalue(L, 2);// cfunc cache key
+						lua_pushlightuserdata(L, &class_cache_getter);// cfunc cache key mark
+						lua_rawset(L, -3);// cache[key] = mark, cfunc cache
+						lua_pop(L, 1);// cfunc
 					}
 					lua_pushvalue(L, 1);// cfunc ud
 					lua_call(L, 1, 1);// return cfunc(ud)
@@ -174,7 +299,14 @@ static int class_index_event(lua_State* L)
 				}
 			}
 			lua_settop(L, 4);// ud key mt basemt
-			loop++;
+		}
+		/* other keys may be made without limit, like tables used once */
+		if (cacheable && lua_type(L, 2) == LUA_TSTRING)
+		{
+			lua_rawgeti(L, 3, MT_CACHE);// cache
+			lua_pushvalue(L, 2);// cache key
+			lua_pushlightuserdata(L, &class_cache_miss);// cache key mark
+			lua_rawset(L, -3);// cache[key] = mark, cache
 		}
 		lua_pushnil(L);
 		return 1;
@@ -250,6 +382,7 @@ static int class_newindex_event(lua_State* L)
 	else if (t == LUA_TTABLE)// __newindex for ud`s class
 	{
 		module_newindex_event(L);
+		tolua_classchanged(L, 1);
 	}
 	return 0;
 }
@@ -21,5 +21,8 @@ NS_DOROTHY_BEGIN
 void tolua_moduleevents(lua_State* L);
 int tolua_ismodulemetatable(lua_State* L);
 void tolua_classevents(lua_State* L);
+/* Drop the flattened member lookup of classes inheriting the changed class at index lo,
+	* or of all classes when lo is 0 */
+void tolua_classchanged(lua_State* L, int lo);
 
 NS_DOROTHY_END
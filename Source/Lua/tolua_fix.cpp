@@ -60,28 +60,32 @@ void tolua_pushobject(lua_State* L, Object* object)
 		lua_pushnil(L);
 		return;
 	}
+	/* an object never pushed has no userdata to look up */
+	bool referenced = object->isLuaReferenced();
 	int refid = object->getLuaRef();
 
 	lua_rawgeti(L, LUA_REGISTRYINDEX, TOLUA_UBOX); // ubox
-	lua_rawgeti(L, -1, refid); // ubox ud
-
-	if (lua_isnil(L, -1)) // ud == nil
+	if (referenced)
 	{
+		lua_rawgeti(L, -1, refid); // ubox ud
+		if (!lua_isnil(L, -1)) // ud != nil
+		{
+			lua_replace(L, -2); // ud
+			return;
+		}
 		lua_pop(L, 1); // ubox
-		*r_cast<void**>(lua_newuserdata(L, sizeof(void*))) = object; // ubox newud
-		lua_pushvalue(L, -1); // ubox newud newud
-		lua_insert(L, -3); // newud ubox newud
-		lua_rawseti(L, -2, refid); // ubox[refid] = newud, newud ubox
-		lua_pop(L, 1); // newud
-		lua_rawgeti(L, LUA_REGISTRYINDEX, object->getLuaType()); // newud mt
-		lua_setmetatable(L, -2); // newud<mt>, newud
-		lua_pushvalue(L, TOLUA_NOPEER);
-		lua_setfenv(L, -2);
-		// register oObject GC
-		object->addLuaRef();
-		object->retain();
 	}
-	else lua_remove(L, -2);// ud
+	*r_cast<void**>(lua_newuserdata(L, sizeof(void*))) = object; // ubox newud
+	lua_rawgeti(L, LUA_REGISTRYINDEX, object->getLuaType()); // ubox newud mt
+	lua_setmetatable(L, -2); // newud<mt>, ubox newud
+	lua_pushvalue(L, TOLUA_NOPEER);
+	lua_setfenv(L, -2);
+	lua_pushvalue(L, -1); // ubox newud newud
+	lua_rawseti(L, -3, refid); // ubox[refid] = newud, ubox newud
+	lua_replace(L, -2); // newud
+	// register oObject GC
+	object->addLuaRef();
+	object->retain();
 }
 
 void tolua_typeid(lua_State* L, int typeId, const char* className)
@@ -180,6 +180,23 @@ static int tolua_bnd_class(lua_State* L)
 	return 1;
 }
 
+/* Drop the member lookup caches of classes inheriting the class,
+	* of all classes when called without a class */
+static int tolua_bnd_classchanged(lua_State* L)
+{
+	/* stack: class */
+	if (lua_isnoneornil(L, 1))
+	{
+		tolua_classchanged(L, 0);
+	}
+	else
+	{
+		luaL_checktype(L, 1, LUA_TTABLE);
+		tolua_classchanged(L, 1);
+	}
+	return 0;
+}
+
 void tolua_open(lua_State* L)
 {
 	int top = lua_gettop(L);
@@ -200,6 +217,7 @@ void tolua_open(lua_State* L)
 				tolua_function(L, "class", tolua_bnd_class);
 				tolua_function(L, "setpeer", tolua_bnd_setpeer);
 				tolua_function(L, "getpeer", tolua_bnd_getpeer);
+				tolua_function(L, "classchanged", tolua_bnd_classchanged);
 			tolua_endmodule(L);
 		tolua_endmodule(L);
 	}
@@ -352,6 +370,7 @@ void tolua_cclass(lua_State* L, const char* name, const char* base, lua_CFunctio
 	mapsuper(L, name, base);
 	mapself(L, name);// mt
 	push_collector(L, col);// mt
+	tolua_classchanged(L, 0);
 	lua_pushstring(L, name);// mt name
 	lua_insert(L, -2);// name mt
 	/* assign class metatable to module */
@@ -375,6 +394,7 @@ void tolua_function(lua_State* L, const char* name, lua_CFunction func)
 	lua_pushstring(L, name);
 	lua_pushcfunction(L, func);
 	lua_rawset(L, -3);
+	tolua_classchanged(L, -1);
 }
 
 void tolua_call(lua_State* L, int index, lua_CFunction func)
@@ -391,6 +411,7 @@ void tolua_constant(lua_State* L, const char* name, lua_Number value)
 	lua_pushstring(L, name);
 	tolua_pushnumber(L, value);
 	lua_rawset(L, -3);
+	tolua_classchanged(L, -1);
 }
 
 /* Map string
@@ -401,6 +422,7 @@ void tolua_string(lua_State* L, const char* str)
 	lua_pushstring(L, str);
 	lua_pushstring(L, str);
 	lua_rawset(L, -3);
+	tolua_classchanged(L, -1);
 }
 
 #ifndef TOLUA_RELEASE
@@ -452,6 +474,7 @@ void tolua_variable(lua_State* L, const char* name, lua_CFunction get, lua_CFunc
 		lua_rawset(L, -3);                  /* store variable */
 		lua_pop(L, 1);                      /* pop .set table */
 	}
+	tolua_classchanged(L, -1);
 }
 
 NS_DOROTHY_END
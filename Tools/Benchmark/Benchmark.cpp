@@ -0,0 +1,200 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include "Const/Header.h"
+#include "bx/timer.h"
+
+NS_DOROTHY_BEGIN
+
+/* Micro benchmarks of the engine core, run without window or renderer.
+ Usage: DorothyBenchmark [filter]
+ Only cases with names containing the filter are run. */
+
+struct BenchmarkCase
+{
+	const char* name;
+	int iterations;
+	function<void(int)> run;
+};
+
+class PooledItem
+{
+	double _data[4];
+	USE_MEMORY_POOL(PooledItem)
+};
+MEMORY_POOL(PooledItem)
+
+class BenchmarkObject : public Object
+{
+public:
+	CREATE_FUNC(BenchmarkObject)
+protected:
+	BenchmarkObject() { }
+};
+
+static vector<BenchmarkCase> getBenchmarkCases()
+{
+	return
+	{
+		{"MemoryPool alloc free", 1000, [](int iterations)
+		{
+			vector<PooledItem*> items(1000);
+			for (int i = 0; i < iterations; i++)
+			{
+				for (auto& item : items) item = new PooledItem();
+				for (auto item : items) delete item;
+			}
+		}},
+		{"FrameArena alloc rewind", 1000, [](int iterations)
+		{
+			FrameArena arena;
+			for (int i = 0; i < iterations; i++)
+			{
+				FrameArena::Marker marker = arena.getMarker();
+				for (int n = 0; n < 1000; n++) arena.allocArray<float>(16);
+				arena.rewind(marker);
+			}
+		}},
+		{"Object create autorelease", 100, [](int iterations)
+		{
+			for (int i = 0; i < iterations; i++)
+			{
+				SharedPoolManager.push();
+				for (int n = 0; n < 1000; n++) BenchmarkObject::create();
+				SharedPoolManager.pop();
+			}
+		}},
+		{"Object weak ref get", 1000, [](int iterations)
+		{
+			SharedPoolManager.push();
+			vector<WRef<Object>> refs;
+			for (int n = 0; n < 1000; n++) refs.push_back(WRefMake<Object>(BenchmarkObject::create()));
+			int count = 0;
+			for (int i = 0; i < iterations; i++)
+			{
+				for (const auto& ref : refs) count += ref.get() ? 1 : 0;
+			}
+			SharedPoolManager.pop();
+			AssertUnless(count == iterations * 1000, "weak references expired early.");
+		}},
+		{"Scheduler update 1000 handlers", 1000, [](int iterations)
+		{
+			Ref<Scheduler> scheduler(Scheduler::create());
+			int count = 0;
+			for (int n = 0; n < 1000; n++)
+			{
+				scheduler->schedule([&count](double deltaTime)
+				{
+					DORA_UNUSED_PARAM(deltaTime);
+					count++;
+					return false;
+				});
+			}
+			for (int i = 0; i < iterations; i++) scheduler->update(1.0 / 60);
+		}},
+		{"TimerWheel 1000 timers", 1000, [](int iterations)
+		{
+			TimerWheel wheel;
+			int count = 0;
+			for (int n = 0; n < 1000; n++)
+			{
+				wheel.add(n * 0.001, 0.016, [&count]()
+				{
+					count++;
+					return false;
+				});
+			}
+			for (int i = 0; i < iterations; i++) wheel.update(1.0 / 60);
+		}},
+		{"EventQueue post poll", 1000, [](int iterations)
+		{
+			EventQueue queue;
+			QMessage message;
+			for (int i = 0; i < iterations; i++)
+			{
+				for (int n = 0; n < 100; n++) queue.post(1, n);
+				while (queue.poll(message));
+			}
+		}},
+		{"Atom intern", 1000, [](int iterations)
+		{
+			vector<string> names;
+			for (int n = 0; n < 100; n++) names.push_back("BenchmarkAtom" + std::to_string(n));
+			for (int i = 0; i < iterations; i++)
+			{
+				for (const auto& name : names) Atom::intern(name);
+			}
+		}},
+		{"Content missed full path", 1000, [](int iterations)
+		{
+			for (int i = 0; i < iterations; i++)
+			{
+				for (int n = 0; n < 10; n++) SharedContent.getFullPath("BenchmarkMissing" + std::to_string(n) + ".lua");
+			}
+		}},
+		{"Lua push object", 1000, [](int iterations)
+		{
+			lua_State* L = SharedLueEngine.getState();
+			int top = lua_gettop(L);
+			Ref<Object> object(BenchmarkObject::create());
+			// keep the userdata referenced as an object held by Lua
+			tolua_pushobject(L, object.get());
+			for (int i = 0; i < iterations; i++)
+			{
+				for (int n = 0; n < 1000; n++)
+				{
+					tolua_pushobject(L, object.get());
+					lua_pop(L, 1);
+				}
+			}
+			lua_settop(L, top);
+		}},
+		{"Lua push new object collect", 100, [](int iterations)
+		{
+			lua_State* L = SharedLueEngine.getState();
+			for (int i = 0; i < iterations; i++)
+			{
+				for (int n = 0; n < 1000; n++)
+				{
+					tolua_pushobject(L, BenchmarkObject::create());
+					lua_pop(L, 1);
+				}
+				lua_gc(L, LUA_GCCOLLECT, 0);
+			}
+		}},
+	};
+}
+
+static int runBenchmarks(const string& filter)
+{
+	double frequency = double(bx::getHPFrequency());
+	for (const auto& benchmark : getBenchmarkCases())
+	{
+		if (!filter.empty() && string(benchmark.name).find(filter) == string::npos)
+		{
+			continue;
+		}
+		SharedPoolManager.push();
+		// warm up caches and pools before timing
+		benchmark.run(1);
+		Uint64 start = bx::getHPCounter();
+		benchmark.run(benchmark.iterations);
+		double time = (bx::getHPCounter() - start) / frequency;
+		SharedPoolManager.pop();
+		Print("%-32s %8d iterations %12.3f us/iteration\n",
+			benchmark.name, benchmark.iterations, time * 1000000 / benchmark.iterations);
+	}
+	return 0;
+}
+
+NS_DOROTHY_END
+
+int main(int argc, char* argv[])
+{
+	return Dorothy::runBenchmarks(argc > 1 ? argv[1] : "");
+}
@@ -0,0 +1,257 @@
+/* Copyright (c) 2016 Jin Li, http://www.luvfight.me
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/* Build a pack file read by Content::mountPack.
+
+ DorothyPack <folder> <output> [-store] [-deflate] [-level 0-9]
+
+ Files under the folder are added with names relative to it. Entries
+ are compressed with LZ4, which is cheap to decode when loading, or with
+ deflate at the given level for smaller packs with -deflate. Files already
+ compressed or saving too little are stored to be served from the mapped
+ pack without copying. The layout is in Basic/PackFormat.h. */
+
+#include "Const/Define.h"
+#include "Basic/PackFormat.h"
+#include "Common/Lz4.h"
+#include "FileSystem/tinydir.h"
+#include "zlib.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace Dorothy;
+using std::string;
+using std::vector;
+
+// formats compressed by themselves
+static const char* StoredExtensions[] = {"png", "jpg", "jpeg", "ogg", "mp3", "zip", "pak"};
+// keep compressed entries saving at least 1/8 of the size
+static const uint64_t MinSavingRatio = 8;
+
+struct SourceFile
+{
+	string name;
+	string path;
+	PackEntry entry;
+	vector<uint8_t> data;
+};
+
+static bool isStoredExtension(const string& name)
+{
+	size_t pos = name.rfind('.');
+	if (pos == string::npos)
+	{
+		return false;
+	}
+	string ext = name.substr(pos + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	for (const char* stored : StoredExtensions)
+	{
+		if (ext == stored) return true;
+	}
+	return false;
+}
+
+static bool readFile(const string& path, vector<uint8_t>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	data.resize(size > 0 ? size : 0);
+	bool result = data.empty() || fread(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return result;
+}
+
+static void collectFiles(const string& folder, const string& prefix, vector<SourceFile>& files)
+{
+	tinydir_dir dir;
+	if (tinydir_open(&dir, folder.c_str()) != 0)
+	{
+		fprintf(stderr, "fail to open folder: %s\n", folder.c_str());
+		return;
+	}
+	for (; dir.has_next; tinydir_next(&dir))
+	{
+		tinydir_file file;
+		if (tinydir_readfile(&dir, &file) != 0) continue;
+		// skip ".", ".." and hidden files
+		if (file.name[0] == '.') continue;
+		string name = prefix + file.name;
+		if (file.is_dir)
+		{
+			collectFiles(file.path, name + '/', files);
+		}
+		else
+		{
+			files.push_back({name, file.path, PackEntry(), vector<uint8_t>()});
+		}
+	}
+	tinydir_close(&dir);
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + PackFormat::Alignment - 1) & ~(PackFormat::Alignment - 1);
+}
+
+static void writePadding(FILE* file, uint64_t& offset)
+{
+	static const char zeros[PackFormat::Alignment] = {0};
+	uint64_t aligned = alignOffset(offset);
+	fwrite(zeros, 1, static_cast<size_t>(aligned - offset), file);
+	offset = aligned;
+}
+
+int main(int argc, char* argv[])
+{
+	string folder, output;
+	bool storeOnly = false;
+	bool deflate = false;
+	int level = Z_BEST_COMPRESSION;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-store") == 0) storeOnly = true;
+		else if (strcmp(argv[i], "-deflate") == 0) deflate = true;
+		else if (strcmp(argv[i], "-level") == 0 && i + 1 < argc) level = std::max(0, std::min(9, atoi(argv[++i])));
+		else if (folder.empty()) folder = argv[i];
+		else output = argv[i];
+	}
+	if (folder.empty() || output.empty())
+	{
+		fprintf(stderr, "usage: DorothyPack <folder> <output> [-store] [-deflate] [-level 0-9]\n");
+		return 1;
+	}
+
+	vector<SourceFile> files;
+	collectFiles(folder, "", files);
+	uint64_t namesSize = 0;
+	for (SourceFile& file : files)
+	{
+		if (!readFile(file.path, file.data))
+		{
+			fprintf(stderr, "fail to read file: %s\n", file.path.c_str());
+			return 1;
+		}
+		if (file.data.size() > UINT32_MAX || file.name.size() > UINT16_MAX)
+		{
+			fprintf(stderr, "file is too large to pack: %s\n", file.path.c_str());
+			return 1;
+		}
+		PackEntry& entry = file.entry;
+		memset(&entry, 0, sizeof(PackEntry));
+		entry.hash = PackHash(file.name.c_str(), file.name.size());
+		entry.nameOffset = static_cast<uint32_t>(namesSize);
+		entry.nameLength = static_cast<uint16_t>(file.name.size());
+		entry.originalSize = static_cast<uint32_t>(file.data.size());
+		entry.compression = PackFormat::Stored;
+		namesSize += file.name.size();
+		if (storeOnly || file.data.empty() || isStoredExtension(file.name))
+		{
+			continue;
+		}
+		vector<uint8_t> compressed;
+		uint64_t size = 0;
+		if (deflate)
+		{
+			uLongf deflatedSize = compressBound(static_cast<uLong>(file.data.size()));
+			compressed.resize(deflatedSize);
+			if (compress2(compressed.data(), &deflatedSize, file.data.data(), static_cast<uLong>(file.data.size()), level) == Z_OK)
+			{
+				size = deflatedSize;
+			}
+		}
+		else
+		{
+			compressed.resize(Lz4::compressBound(file.data.size()));
+			size = Lz4::compress(file.data.data(), file.data.size(), compressed.data());
+		}
+		if (size > 0 && size < file.data.size() - file.data.size() / MinSavingRatio)
+		{
+			compressed.resize(size);
+			file.data.swap(compressed);
+			entry.compression = deflate ? PackFormat::Deflate : PackFormat::Lz4;
+		}
+	}
+	if (namesSize > UINT32_MAX)
+	{
+		fprintf(stderr, "too many files to pack.\n");
+		return 1;
+	}
+	std::sort(files.begin(), files.end(), [](const SourceFile& a, const SourceFile& b)
+	{
+		return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.name < b.name;
+	});
+
+	PackHeader header;
+	memset(&header, 0, sizeof(PackHeader));
+	memcpy(header.magic, PackFormat::Magic, sizeof(header.magic));
+	header.version = PackFormat::Version;
+	header.entryCount = static_cast<uint32_t>(files.size());
+	header.namesSize = static_cast<uint32_t>(namesSize);
+	header.namesOffset = sizeof(PackHeader) + files.size() * sizeof(PackEntry);
+	uint64_t offset = alignOffset(header.namesOffset + namesSize);
+	for (SourceFile& file : files)
+	{
+		file.entry.offset = offset;
+		file.entry.size = static_cast<uint32_t>(file.data.size());
+		offset = alignOffset(offset + file.data.size());
+	}
+
+	FILE* out = fopen(output.c_str(), "wb");
+	if (!out)
+	{
+		fprintf(stderr, "fail to write file: %s\n", output.c_str());
+		return 1;
+	}
+	// the pack is read in place, numbers are written in the little endian of the host
+	fwrite(&header, sizeof(PackHeader), 1, out);
+	for (const SourceFile& file : files)
+	{
+		fwrite(&file.entry, sizeof(PackEntry), 1, out);
+	}
+	// names are written in the order of name offsets
+	vector<const SourceFile*> byName(files.size());
+	std::transform(files.begin(), files.end(), byName.begin(), [](const SourceFile& file) { return &file; });
+	std::sort(byName.begin(), byName.end(), [](const SourceFile* a, const SourceFile* b)
+	{
+		return a->entry.nameOffset < b->entry.nameOffset;
+	});
+	for (const SourceFile* file : byName)
+	{
+		fwrite(file->name.data(), 1, file->name.size(), out);
+	}
+	offset = header.namesOffset + namesSize;
+	uint64_t originalSize = 0;
+	for (const SourceFile& file : files)
+	{
+		writePadding(out, offset);
+		fwrite(file.data.data(), 1, file.data.size(), out);
+		offset += file.data.size();
+		originalSize += file.entry.originalSize;
+	}
+	bool result = ferror(out) == 0;
+	fclose(out);
+	if (!result)
+	{
+		fprintf(stderr, "fail to write file: %s\n", output.c_str());
+		return 1;
+	}
+	printf("packed %d files, %llu bytes into %llu bytes.\n", static_cast<int>(files.size()),
+		static_cast<unsigned long long>(originalSize), static_cast<unsigned long long>(offset));
+	return 0;
+}
@@ -4,12 +4,29 @@ class Object @ oObject
 {
 	tolua_readonly tolua_property__common unsigned int id;
 	tolua_readonly tolua_property__common unsigned int luaRef @ ref;
+	tolua_readonly tolua_property__common double handle;
 	static tolua_readonly tolua_property__common unsigned int objectCount @ count;
 	static tolua_readonly tolua_property__common unsigned int maxObjectCount @ maxCount;
 	static tolua_readonly tolua_property__common unsigned int luaRefCount;
 	static tolua_readonly tolua_property__common unsigned int maxLuaRefCount;
 	static tolua_readonly tolua_property__common unsigned int luaCallbackCount @ callRefCount;
 	static tolua_readonly tolua_property__common unsigned int maxLuaCallbackCount @ maxCallRefCount;
+	static Object* get(double handle);
+};
+
+class MemoryPoolBase @ oMemoryPool
+{
+	tolua_readonly tolua_property__common string name;
+	tolua_readonly tolua_property__common int itemSize;
+	tolua_readonly tolua_property__common int itemCount;
+	tolua_readonly tolua_property__common int freeCount;
+	tolua_readonly tolua_property__common int chunkCount;
+	tolua_readonly tolua_property__common int capacity;
+	tolua_readonly tolua_property__common int highWater;
+	tolua_readonly tolua_property__common double allocRate;
+	static tolua_readonly tolua_property__common int count;
+	static MemoryPoolBase* getPool @ get(int index);
+	static int getTotalCapacity @ totalCapacity();
 };
 
 class Content @ oContent
@@ -21,9 +38,13 @@ class Content @ oContent
     bool isFolder @ isdir(String path);
 	bool removeFile @ remove(String path);
     string getFullPath(String filename);
+	bool hasFile(String filename);
+	void clearPathCache();
 
 	void addSearchPath(String path);
 	void removeSearchPath(String path);
+	bool mountPack(String packFile);
+	void unmountPack(String packFile);
 	tolua_outside void Content_getDirEntries @ getEntries(String path, bool isFolder);
 	tolua_outside void Content_loadFile @ loadFile(String filename);
 	tolua_outside void Content_setSearchPaths @ setSearchPaths(String paths[tolua_len]);
@@ -33,12 +54,16 @@ class Content @ oContent
 
 class Event @ oEvent
 {
+	tolua_readonly tolua_property__common unsigned int id;
 	tolua_readonly tolua_property__common string name;
 };
+unsigned int Atom::intern @ atom(String name);
 void Event::send @ emit(String name);
+void Event::send @ emit(unsigned int id);
 
 class Listener @ oSlot : public Object
 {
+	tolua_readonly tolua_property__common unsigned int id;
 	tolua_readonly tolua_property__common string name;
 	tolua_property__bool bool enabled;
 };